@@ -0,0 +1,371 @@
+#include "hierarchical.hpp"
+#include "jumptable.hpp"
+#include "landmarks.hpp"
+#include "mapio.hpp"
+#include "search.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+// Self-contained benchmark. Runs a fixed, seeded query set per map and algorithm and reports
+// queries/sec, search counters, setup vs search time and peak memory, optionally as JSON.
+// Counters are null when the library is built with PATHFINDING_STATS off.
+// On Linux the peak is reset before every case, elsewhere it is the peak of the whole process so far.
+//
+//   PathfindingBenchmark [--sizes 64,256,1024,4096] [--queries 64] [--seed 1]
+//                        [--algorithms astar,alt,bidir,jps,jps+,hpa] [--assets assets] [--json results.json]
+
+using namespace Pathfinding;
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	double Milliseconds(Clock::time_point from, Clock::time_point to) {
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	}
+
+	// Starts the peak over from current use. False where only the process peak is known
+	bool ResetPeakMemory() {
+#ifdef __linux__
+		std::ofstream clearRefs("/proc/self/clear_refs");
+		clearRefs << "5";
+		clearRefs.close();
+		return (bool)clearRefs;
+#else
+		return false;
+#endif
+	}
+
+	long PeakMemoryKb() {
+#ifdef __linux__
+		// Unlike ru_maxrss this follows ResetPeakMemory
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while(std::getline(status, line)) {
+			if(line.rfind("VmHWM:", 0) == 0) return atol(line.c_str() + 6);
+		}
+#endif
+#ifdef __unix__
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+#else
+		return 0;
+#endif
+	}
+
+	std::vector<std::string> Split(const std::string& text) {
+		std::vector<std::string> parts;
+		std::stringstream stream(text);
+		std::string part;
+		while(std::getline(stream, part, ',')) {
+			if(!part.empty()) parts.push_back(part);
+		}
+		return parts;
+	}
+
+	// Maps
+
+	MapData OpenMap(uint size) {
+		MapData map;
+		map.grid.Resize(size, size);
+		for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+			map.grid.SetWalkable(cell, true);
+		}
+		return map;
+	}
+
+	MapData RandomMap(uint size, std::mt19937& random) {
+		MapData map;
+		map.grid.Resize(size, size);
+		for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+			map.grid.SetWalkable(cell, random() % 100 >= 25);
+		}
+		return map;
+	}
+
+	// Random obstacles on patches of terrain costing 1 to 4 times plain floor
+	MapData TerrainMap(uint size, std::mt19937& random) {
+		MapData map = RandomMap(size, random);
+		const uint patch = 8;
+		uint patchesPerRow = (size + patch - 1) / patch;
+		std::vector<uint8_t> patchCosts((size_t)patchesPerRow * patchesPerRow);
+		for(uint8_t& cost : patchCosts) {
+			cost = (uint8_t)(1 + random() % 4);
+		}
+
+		map.costs.Resize(map.grid.CellCount());
+		for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+			if(!map.grid.IsWalkable(cell)) continue;
+			Position pos = map.grid.ToPosition(cell);
+			map.costs.Set(cell, patchCosts[pos.x / patch + pos.y / patch * (size_t)patchesPerRow]);
+		}
+		return map;
+	}
+
+	// Recursive backtracker with corridors one cell wide. Corridors sit on odd coordinates
+	MapData MazeMap(uint size, std::mt19937& random) {
+		MapData map;
+		map.grid.Resize(size, size);
+		uint rooms = (size - 1) / 2;
+		if(rooms == 0) return map;
+
+		std::vector<bool> visited((size_t)rooms * rooms, false);
+		std::vector<std::pair<uint, uint>> stack;
+		stack.push_back({ 0, 0 });
+		visited[0] = true;
+		map.grid.SetWalkable(map.grid.Index(1, 1), true);
+
+		const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+		while(!stack.empty()) {
+			auto [x, y] = stack.back();
+			int options[4];
+			int optionCount = 0;
+			for(int i = 0; i < 4; i++) {
+				int nextX = (int)x + offsets[i][0];
+				int nextY = (int)y + offsets[i][1];
+				if(nextX < 0 || nextY < 0 || nextX >= (int)rooms || nextY >= (int)rooms) continue;
+				if(visited[nextX + nextY * (size_t)rooms]) continue;
+				options[optionCount++] = i;
+			}
+			if(optionCount == 0) {
+				stack.pop_back();
+				continue;
+			}
+
+			int choice = options[random() % optionCount];
+			uint nextX = x + offsets[choice][0];
+			uint nextY = y + offsets[choice][1];
+			visited[nextX + nextY * (size_t)rooms] = true;
+			// Carve the wall between the rooms and the next room
+			map.grid.SetWalkable(map.grid.Index(x * 2 + 1 + offsets[choice][0], y * 2 + 1 + offsets[choice][1]), true);
+			map.grid.SetWalkable(map.grid.Index(nextX * 2 + 1, nextY * 2 + 1), true);
+			stack.push_back({ nextX, nextY });
+		}
+		return map;
+	}
+
+	std::vector<std::pair<CellIndex, CellIndex>> MakeQueries(const Grid& grid, uint count, std::mt19937& random) {
+		std::vector<CellIndex> floor;
+		for(CellIndex cell = 0; cell < grid.CellCount(); cell++) {
+			if(grid.IsWalkable(cell)) floor.push_back(cell);
+		}
+
+		std::vector<std::pair<CellIndex, CellIndex>> queries;
+		if(floor.empty()) return queries;
+		for(uint i = 0; i < count; i++) {
+			queries.push_back({ floor[random() % floor.size()], floor[random() % floor.size()] });
+		}
+		return queries;
+	}
+
+	struct CaseResult {
+		std::string map;
+		uint width = 0;
+		uint height = 0;
+		std::string algorithm;
+		uint queries = 0;
+		uint found = 0;
+		SearchStats stats; // Summed over all queries
+		double loadMs = 0;
+		double setupMs = 0;
+		double searchMs = 0;
+		long peakMemoryKb = 0;
+	};
+
+	CaseResult RunCase(const std::string& name, const MapData& map, double loadMs, const std::string& algorithm,
+			   const std::vector<std::pair<CellIndex, CellIndex>>& queries) {
+		CaseResult result;
+		result.map = name;
+		result.width = map.grid.Width();
+		result.height = map.grid.Height();
+		result.algorithm = algorithm;
+		result.queries = (uint)queries.size();
+		result.loadMs = loadMs;
+
+		Clock::time_point setupStart = Clock::now();
+		JumpTable jumpTable;
+		ClusterGraph clusterGraph;
+		std::unique_ptr<HierarchicalPathfinder> hierarchical;
+		Landmarks landmarks;
+		Search search;
+		if(algorithm == "hpa") {
+			clusterGraph.Build(map.grid);
+			hierarchical = std::make_unique<HierarchicalPathfinder>(clusterGraph);
+		}
+		else {
+			search.SetGrid(&map.grid);
+			search.SetCosts(&map.costs);
+			if(algorithm == "jps+") {
+				jumpTable.Build(map.grid);
+				search.SetAlgorithm(JumpPointSearchPlus, &jumpTable);
+			}
+			else if(algorithm == "jps") {
+				search.SetAlgorithm(JumpPointSearch);
+			}
+			else if(algorithm == "bidir") {
+				search.SetAlgorithm(Bidirectional);
+			}
+			else if(algorithm == "alt") {
+				landmarks.Build(map.grid);
+				search.SetLandmarks(&landmarks);
+			}
+		}
+		Clock::time_point searchStart = Clock::now();
+		result.setupMs = Milliseconds(setupStart, searchStart);
+
+		for(const auto& query : queries) {
+			PathResult path = hierarchical ? hierarchical->Solve(query.first, query.second)
+						       : search.Solve(query.first, query.second);
+			if(path.found) result.found++;
+			result.stats += path.stats;
+		}
+		result.searchMs = Milliseconds(searchStart, Clock::now());
+		result.peakMemoryKb = PeakMemoryKb();
+		return result;
+	}
+
+	void PrintCounter(std::ostream& out, uint64_t value) {
+		if(PATHFINDING_STATS) out << value;
+		else out << "null";
+	}
+
+	void PrintJson(std::ostream& out, const std::vector<CaseResult>& results, uint seed, bool peakPerCase) {
+		out << "{\n  \"seed\": " << seed << ",\n  \"peak_memory\": \"" << (peakPerCase ? "case" : "process")
+		    << "\",\n  \"results\": [\n";
+		for(size_t i = 0; i < results.size(); i++) {
+			const CaseResult& r = results[i];
+			double queriesPerSecond = r.searchMs > 0 ? r.queries * 1000.0 / r.searchMs : 0;
+			out << "    {\"map\": \"" << r.map << "\", \"width\": " << r.width << ", \"height\": " << r.height
+			    << ", \"algorithm\": \"" << r.algorithm << "\", \"queries\": " << r.queries << ", \"found\": " << r.found
+			    << ", \"nodes_expanded\": ";
+			PrintCounter(out, r.stats.nodesExpanded);
+			out << ", \"nodes_generated\": ";
+			PrintCounter(out, r.stats.nodesGenerated);
+			out << ", \"open_set_peak\": ";
+			PrintCounter(out, r.stats.openSetPeak);
+			out << ", \"heap_pushes\": ";
+			PrintCounter(out, r.stats.heapPushes);
+			out << ", \"heap_pops\": ";
+			PrintCounter(out, r.stats.heapPops);
+			out << ", \"heap_updates\": ";
+			PrintCounter(out, r.stats.heapUpdates);
+			out << ", \"reopened\": ";
+			PrintCounter(out, r.stats.reopened);
+			out << ", \"queries_per_second\": " << queriesPerSecond << ", \"load_ms\": " << r.loadMs
+			    << ", \"setup_ms\": " << r.setupMs << ", \"search_ms\": " << r.searchMs
+			    << ", \"phase_setup_ms\": " << r.stats.setupNs / 1e6 << ", \"phase_search_ms\": " << r.stats.searchNs / 1e6
+			    << ", \"phase_path_ms\": " << r.stats.pathNs / 1e6
+			    << ", \"peak_memory_kb\": " << r.peakMemoryKb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> sizes = { "64", "256", "1024", "4096" };
+	std::vector<std::string> algorithms = { "astar", "alt", "bidir", "jps", "jps+", "hpa" };
+	uint queryCount = 64;
+	uint seed = 1;
+	std::string assets = "assets";
+	std::string jsonPath;
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(i + 1 >= argc) {
+			printf("ERROR: %s needs a value\n", arg.c_str());
+			return 1;
+		}
+		std::string value = argv[++i];
+		if(arg == "--sizes") sizes = Split(value);
+		else if(arg == "--algorithms") algorithms = Split(value);
+		else if(arg == "--queries") queryCount = (uint)atoi(value.c_str());
+		else if(arg == "--seed") seed = (uint)atoi(value.c_str());
+		else if(arg == "--assets") assets = value;
+		else if(arg == "--json") jsonPath = value;
+		else {
+			printf("ERROR: Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<CaseResult> results;
+	bool peakPerCase = true;
+	auto runMap = [&](const std::string& name, const MapData& map, double loadMs) {
+		// Same queries for every algorithm
+		std::mt19937 random(seed);
+		std::vector<std::pair<CellIndex, CellIndex>> queries = MakeQueries(map.grid, queryCount, random);
+		const CaseResult* astar = nullptr;
+		const CaseResult* jps = nullptr;
+		size_t first = results.size();
+		for(const std::string& algorithm : algorithms) {
+			// HPA* ignores terrain, its costs and counts wouldn't compare with the grid searches
+			if(algorithm == "hpa" && !map.costs.Empty()) continue;
+			peakPerCase = ResetPeakMemory() && peakPerCase;
+			CaseResult result = RunCase(name, map, loadMs, algorithm, queries);
+			printf("%-10s %5ux%-5u %-6s %6u queries %6u found %12llu expanded %10.1f q/s  load %8.2f ms  setup %8.2f ms  search %9.2f ms  peak %ld KB\n",
+			       result.map.c_str(), result.width, result.height, result.algorithm.c_str(), result.queries, result.found,
+			       (unsigned long long)result.stats.nodesExpanded, result.searchMs > 0 ? result.queries * 1000.0 / result.searchMs : 0.0,
+			       result.loadMs, result.setupMs, result.searchMs, result.peakMemoryKb);
+			fflush(stdout);
+			results.push_back(result);
+		}
+		for(size_t i = first; i < results.size(); i++) {
+			if(results[i].algorithm == "astar") astar = &results[i];
+			if(results[i].algorithm == "jps") jps = &results[i];
+		}
+		// Jumps must pay for themselves, most of all on open maps where they skip the most cells
+		if(astar && jps && astar->searchMs > 0) {
+			printf("%-10s %5ux%-5u jps searches in %.2fx the time of astar\n", name.c_str(), map.grid.Width(), map.grid.Height(),
+			       jps->searchMs / astar->searchMs);
+		}
+	};
+
+	for(const char* file : { "input.bmp", "input2.bmp" }) {
+		MapData map;
+		Clock::time_point loadStart = Clock::now();
+		if(!LoadBitmap(assets + "/" + file, map)) continue;
+		runMap(file, map, Milliseconds(loadStart, Clock::now()));
+	}
+
+	for(const std::string& sizeText : sizes) {
+		uint size = (uint)atoi(sizeText.c_str());
+		if(size < 3) continue;
+
+		std::mt19937 random(seed);
+		Clock::time_point loadStart = Clock::now();
+		MapData open = OpenMap(size);
+		runMap("open", open, Milliseconds(loadStart, Clock::now()));
+
+		loadStart = Clock::now();
+		MapData obstacles = RandomMap(size, random);
+		runMap("random", obstacles, Milliseconds(loadStart, Clock::now()));
+
+		loadStart = Clock::now();
+		MapData terrain = TerrainMap(size, random);
+		runMap("terrain", terrain, Milliseconds(loadStart, Clock::now()));
+
+		loadStart = Clock::now();
+		MapData maze = MazeMap(size, random);
+		runMap("maze", maze, Milliseconds(loadStart, Clock::now()));
+	}
+
+	if(!jsonPath.empty()) {
+		std::ofstream json(jsonPath);
+		if(!json) {
+			printf("ERROR: Could not open %s\n", jsonPath.c_str());
+			return 1;
+		}
+		PrintJson(json, results, seed, peakPerCase);
+	}
+	return 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "components.hpp"
+#include "flowfield.hpp"
+#include "grid.hpp"
+#include "hierarchical.hpp"
+#include "pathcache.hpp"
+#include "search.hpp"
+
+namespace Pathfinding {
+	struct PathQuery {
+		Position start;
+		Position end;
+	};
+
+	// Solves many queries against one read-only map on a pool of worker threads.
+	// Every worker keeps its own Search so scratch memory is allocated once per thread,
+	// not once per query, and only by a worker's first grid search. Its pages are committed
+	// as searches reach cells, so idle workers and short queries cost next to no memory.
+	// Queries are split evenly between workers up front
+	// and idle workers steal half of the remaining range from a busy one.
+	// Queries between different components are answered without searching
+	class BatchSolver {
+	public:
+		// threadCount 0 uses every hardware thread
+		BatchSolver(const Grid& grid, uint threadCount = 0);
+		~BatchSolver();
+
+		BatchSolver(const BatchSolver&) = delete;
+		BatchSolver& operator=(const BatchSolver&) = delete;
+
+		// Not safe to call while Solve is running
+		void SetAlgorithm(Algorithm algorithm);
+
+		// Prebuilt JPS+ table of the same grid, like the one loaded with a compact map.
+		// Call before SetAlgorithm to skip building one. Not safe to call while Solve is running
+		void SetJumpTable(JumpTable table) { jumpTable = std::move(table); }
+
+		// Answer queries through HPA* with clusters of the given size, 0 goes back to grid search.
+		// Not safe to call while Solve is running
+		void SetHierarchical(uint clusterSize);
+
+		// Movement rules of grid searches. HPA* and flow fields keep 8-way octile moves.
+		// Components are labelled again when diagonal moves past corners are switched on or off.
+		// Not safe to call while Solve is running
+		void SetPolicy(SearchPolicy policy);
+
+		// Terrain costs of the same grid for grid searches, nullptr for uniform cost.
+		// HPA* and flow fields ignore terrain. Not safe to call while Solve is running
+		void SetCosts(const TerrainCosts* costs);
+
+		// ALT heuristic for grid searches with the given number of landmarks, 0 turns it off.
+		// Not safe to call while Solve is running
+		void SetLandmarks(uint count);
+
+		// Answer queries from one FlowField per distinct end instead of searching each one.
+		// Pays off when many queries share an end. Not safe to call while Solve is running
+		void SetFlowField(bool enabled) { useFlowField = enabled; }
+
+		// Grid search results kept between queries and Solve calls, shared by all workers.
+		// Queries along a cached path are answered by slicing it. 0 turns the cache off.
+		// Call Cache().SetWalkable for cells changed between Solve calls.
+		// Not safe to call while Solve is running
+		void SetCache(size_t capacity) { cache.SetCapacity(capacity); }
+		PathCache& Cache() { return cache; }
+
+		std::vector<PathResult> Solve(const std::vector<PathQuery>& queries);
+
+		uint ThreadCount() const { return (uint)workers.size(); }
+
+	private:
+		// Remaining query range [begin, end) packed as begin | end << 32 so the owner
+		// and thieves can both update it with a single compare-and-swap
+		struct alignas(64) Worker {
+			std::atomic<uint64_t> range{ 0 };
+			Search search;
+			bool searchReady = false; // Grid given on first use
+			std::unique_ptr<HierarchicalPathfinder> hierarchical;
+			std::thread thread;
+		};
+
+		const Grid& grid;
+		Components components;
+		JumpTable jumpTable; // Shared by all workers, given or built on first use of JumpPointSearchPlus
+		ClusterGraph clusterGraph;
+		FlowField flowField;
+		Landmarks landmarks;
+		PathCache cache{ 0 };
+		bool useFlowField = false;
+		std::vector<std::unique_ptr<Worker>> workers;
+
+		// Current job, shared with the workers
+		const std::vector<PathQuery>* queries = nullptr;
+		std::vector<PathResult>* results = nullptr;
+
+		std::mutex mutex;
+		std::condition_variable wakeWorkers;
+		std::condition_variable jobDone;
+		uint64_t jobId = 0;
+		uint busyWorkers = 0;
+		bool stopping = false;
+
+		void WorkerLoop(uint index);
+		bool TakeOwn(Worker& worker, uint32_t& query);
+		bool Steal(uint thief);
+		void SolveWithFlowFields(const std::vector<PathQuery>& queries, std::vector<PathResult>& results);
+	};
+}
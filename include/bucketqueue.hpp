@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "grid.hpp"
+#include "zeroedarray.hpp"
+
+namespace Pathfinding {
+	// Open set for small integer keys (Dial's algorithm): one bucket per fCost in a sliding window,
+	// so push, decrease-key and pop are O(1) plus the empty buckets stepped over, with no comparisons.
+	// Decrease-key leaves the old entry behind, pops skip entries whose key has changed.
+	// The window width is a power of two and doubles when the open keys spread further apart.
+	// Cells of equal fCost come out last in, first out, which favours the latest generated ones.
+	// Takes the same calls from the searches as OpenSet, hCost is ignored
+	class BucketQueue {
+	public:
+		BucketQueue() = default;
+
+		// Must be called with the map's cell count before use
+		void Resize(size_t cellCount);
+		size_t CellCount() const { return keys.size(); }
+
+		void Push(CellIndex cell, int fCost, int hCost);
+		CellIndex Pop();
+
+		// Key must be lower than the current one
+		void DecreaseKey(CellIndex cell, int fCost, int hCost);
+
+		// Not const, drops outdated entries on the way to the lowest key
+		int TopFCost();
+		// Cell must be queued
+		int GetFCost(CellIndex cell) const { return Key(cell); }
+
+		bool Contains(CellIndex cell) const { return Key(cell) != NOT_QUEUED; }
+		bool Empty() const { return count == 0; }
+		size_t Size() const { return count; }
+
+		void Clear();
+
+	private:
+		static constexpr int NOT_QUEUED = INT32_MIN;
+		static constexpr size_t INITIAL_BUCKETS = 1024;
+
+		std::vector<std::vector<CellIndex>> buckets;
+		// Current key of each queued cell, stored with the sign bit flipped so the zeroed array
+		// reads as NOT_QUEUED without being written
+		ZeroedArray<int> keys;
+		size_t count = 0;      // Queued cells
+		size_t entries = 0;    // Bucket entries, outdated ones included
+		// Every queued key lies in [lowest, highest], which always fits in the window
+		int lowest = 0;
+		int highest = 0;
+
+		int Key(CellIndex cell) const { return keys[cell] ^ NOT_QUEUED; }
+		void SetKey(CellIndex cell, int key) { keys[cell] = key ^ NOT_QUEUED; }
+		std::vector<CellIndex>& Bucket(int key) { return buckets[(uint32_t)key & (buckets.size() - 1)]; }
+		void Insert(CellIndex cell, int fCost);
+		void Grow(size_t spread);
+		// Moves lowest up to the first bucket with a current entry on top
+		void Advance();
+	};
+}
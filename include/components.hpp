@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "grid.hpp"
+
+namespace Pathfinding {
+	// Labels every walkable cell with its connected component, either 8-connected with diagonal
+	// moves past wall corners or 4-connected. Moves that don't cut corners connect the same cells
+	// as 4-way ones. Two cells have a path between them exactly when Connected says so,
+	// which lets searches drop hopeless queries up front
+	class Components {
+	public:
+		static constexpr uint32_t NO_COMPONENT = UINT32_MAX;
+
+		Components() = default;
+
+		// Two raster passes with union-find over the provisional labels, O(map size)
+		void Build(const Grid& grid, bool diagonal = true);
+		bool Empty() const { return labels.empty(); }
+		bool Diagonal() const { return diagonal; }
+
+		// Whether the labels can rule out paths with or without diagonal moves.
+		// 8-connected ones hold for every move rule, 4-connected ones only without diagonals
+		bool Separates(bool diagonalMoves) const { return diagonal || !diagonalMoves; }
+
+		// Call after the grid cell changed. Opening a cell merges its neighbours' components.
+		// Closing one only costs a flood fill when its neighbours no longer touch each other
+		void SetWalkable(const Grid& grid, CellIndex cell, bool walkable);
+
+		// Walls have no component
+		uint32_t Get(CellIndex cell) const { return labels[cell] == NO_COMPONENT ? NO_COMPONENT : Find(labels[cell]); }
+		bool Connected(CellIndex cellA, CellIndex cellB) const {
+			return Get(cellA) != NO_COMPONENT && Get(cellA) == Get(cellB);
+		}
+
+	private:
+		std::vector<uint32_t> labels; // Per cell, NO_COMPONENT for walls
+		std::vector<uint32_t> parent; // Union-find over labels, roots point to themselves
+		std::vector<CellIndex> queue; // Flood fill scratch
+		bool diagonal = true;
+
+		uint32_t Find(uint32_t label) const;
+		uint32_t Compress(uint32_t label);
+		uint32_t Union(uint32_t labelA, uint32_t labelB);
+		void Flood(const Grid& grid, CellIndex seed, uint32_t label);
+	};
+}
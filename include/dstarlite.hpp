@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include "grid.hpp"
+#include "openset.hpp"
+#include "search.hpp"
+
+namespace Pathfinding {
+	// D* Lite incremental search. Searches backwards from the end so the start can move
+	// and cells can toggle between wall and floor without throwing the search away.
+	// Replanning only touches cells whose cost actually changed.
+	// Moving the end needs a new Begin
+	class DStarLite {
+	public:
+		DStarLite() = default;
+
+		// The grid is edited through SetWalkable so the search can repair itself
+		void SetGrid(Grid* grid);
+
+		// Starts over from nothing, O(map size)
+		void Begin(CellIndex start, CellIndex end);
+
+		void MoveStart(CellIndex start);
+		void SetWalkable(CellIndex cell, bool walkable);
+
+		// Processes one inconsistent cell and returns it. INVALID_CELL when the path is up to date
+		CellIndex Step();
+
+		// Steps until the path is up to date. Returns whether a path exists
+		bool Run();
+
+		bool UpToDate();
+
+		// Current best path from start to end. Only optimal when UpToDate
+		PathResult GetPath();
+
+		// Work since the first edit or start move after the previous GetPath.
+		// Cells raised by a wall edit and queued again count as reopened
+		const SearchStats& GetStats() const { return stats.Get(); }
+
+		// Cells from the given one towards the end, following the cheapest neighbours
+		std::vector<Position> RetracePath(CellIndex cell);
+
+		NodeState GetState(CellIndex cell) const;
+
+		CellIndex GetStart() const { return startNode; }
+		CellIndex GetEnd() const { return endNode; }
+
+	private:
+		static constexpr int INFINITE_COST = INT32_MAX / 4;
+
+		Grid* grid = nullptr;
+		CellIndex startNode = INVALID_CELL;
+		CellIndex endNode = INVALID_CELL;
+		CellIndex lastStart = INVALID_CELL;
+		int keyModifier = 0;
+
+		std::vector<int> gCost;
+		std::vector<int> rhs; // One step lookahead of gCost
+		OpenSet queue;
+		Stats stats;
+		bool statsReported = false;
+
+		// Key is (min(g, rhs) + h + keyModifier, min(g, rhs)), compared in that order like OpenSet does
+		void CalculateKey(CellIndex cell, int& first, int& second);
+		bool KeyLess(int firstA, int secondA, int firstB, int secondB);
+
+		void UpdateVertex(CellIndex cell);
+		int BestNeighbourCost(CellIndex cell);
+		int EdgeCost(CellIndex cellA, CellIndex cellB);
+
+		void StartReplan();
+
+		int GetNeighbourNodes(CellIndex cell, CellIndex* neighbours);
+		int GetDistance(CellIndex cellA, CellIndex cellB) const;
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "grid.hpp"
+#include "search.hpp"
+
+namespace Pathfinding {
+	// Cost to one goal from every cell, plus the direction of the next step.
+	// Built once with a reverse Dijkstra from the goal, after that any number of agents
+	// read their path in O(path length) without searching. 5 bytes per cell
+	class FlowField {
+	public:
+		static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+		static constexpr uint8_t NO_DIRECTION = 0xFF;
+
+		FlowField() = default;
+
+		// The frontier is processed in distance buckets 10 wide. Every move costs at least 10,
+		// so a bucket only feeds later ones and its cells can be relaxed in parallel.
+		// threadCount 0 uses every hardware thread, small maps always use one
+		void Build(const Grid& grid, CellIndex goal, uint threadCount = 0);
+		bool Empty() const { return grid == nullptr; }
+
+		CellIndex GetGoal() const { return goal; }
+
+		// Path cost from the cell to the goal, UNREACHABLE for walls and walled-off cells
+		uint32_t GetDistance(CellIndex cell) const { return distance[cell]; }
+
+		// One of the 8 neighbours, INVALID_CELL on the goal and where the goal can't be reached
+		CellIndex Next(CellIndex cell) const;
+
+		// Follows the field from start to the goal
+		PathResult GetPath(CellIndex start) const;
+
+	private:
+		const Grid* grid = nullptr;
+		CellIndex goal = INVALID_CELL;
+
+		std::vector<uint32_t> distance;
+		std::vector<uint8_t> direction; // Index into the neighbour offsets
+
+		void BuildDirections(uint firstRow, uint endRow);
+	};
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+
+namespace Pathfinding {
+	struct Position {
+		uint x;
+		uint y;
+
+		bool operator ==(const Position& pos) const {
+			if(x == pos.x && y == pos.y) {
+				return true;
+			}
+			return false;
+		};
+
+		bool operator !=(const Position& pos) const {
+			if(x != pos.x || y != pos.y) {
+				return true;
+			}
+			return false;
+		};
+	};
+	struct Size {
+		uint width;
+		uint height;
+	};
+
+	// Cells are addressed by a flat index x + y * width
+	typedef uint32_t CellIndex;
+	constexpr CellIndex INVALID_CELL = UINT32_MAX;
+
+	// Flat walkability bitmap, one bit per cell so a 16k x 16k map is 32 MB.
+	// The bits are either owned or borrowed from a memory-mapped file, see Attach
+	class Grid {
+	public:
+		Grid() = default;
+		Grid(uint width, uint height);
+
+		// Copies always own their bits, moves keep borrowed ones
+		Grid(const Grid& other);
+		Grid(Grid&& other) noexcept;
+		Grid& operator=(const Grid& other);
+		Grid& operator=(Grid&& other) noexcept;
+
+		// All cells start as walls
+		void Resize(uint width, uint height);
+
+		// Uses bits stored somewhere else without copying them. owner is released with the grid.
+		// SetWalkable writes straight into that memory
+		void Attach(uint width, uint height, uint64_t* bits, std::shared_ptr<void> owner);
+
+		uint Width() const { return size.width; }
+		uint Height() const { return size.height; }
+		Size GetSize() const { return size; }
+		size_t CellCount() const { return cellCount; }
+
+		CellIndex Index(uint x, uint y) const { return x + y * size.width; }
+		Position ToPosition(CellIndex cell) const { return Position{ cell % size.width, cell / size.width }; }
+
+		bool InBounds(int x, int y) const {
+			return x >= 0 && y >= 0 && (uint)x < size.width && (uint)y < size.height;
+		}
+
+		bool IsWalkable(CellIndex cell) const { return (bits[cell >> 6] >> (cell & 63)) & 1; }
+		bool IsWalkable(uint x, uint y) const { return InBounds(x, y) && IsWalkable(Index(x, y)); }
+		void SetWalkable(CellIndex cell, bool value) {
+			uint64_t mask = (uint64_t)1 << (cell & 63);
+			if(value) bits[cell >> 6] |= mask;
+			else bits[cell >> 6] &= ~mask;
+			version++;
+		}
+
+		// Cell c is bit c % 64 of word c / 64. Bits past the last cell are zero
+		const uint64_t* Bits() const { return bits; }
+		size_t WordCount() const { return (cellCount + 63) / 64; }
+
+		// Walkability of the 64 cells from (x, y) to (x + 63, y) as bits 0 to 63.
+		// Cells outside the map, x and y included, read as walls
+		uint64_t RowBits(int x, int y) const {
+			if(y < 0 || (uint)y >= size.height) return 0;
+			int64_t first = std::max<int64_t>(x, 0);
+			int64_t last = std::min<int64_t>((int64_t)x + 64, size.width);
+			if(first >= last) return 0;
+			size_t offset = (size_t)y * size.width + (size_t)first;
+			size_t word = offset >> 6;
+			uint shift = offset & 63;
+			uint64_t value = bits[word] >> shift;
+			if(shift != 0 && word + 1 < WordCount()) value |= bits[word + 1] << (64 - shift);
+			uint count = (uint)(last - first);
+			if(count < 64) value &= ((uint64_t)1 << count) - 1;
+			return value << (first - x);
+		}
+
+		// Same map with x and y swapped, so columns can be read with RowBits
+		Grid Transposed() const;
+
+		// Changes with every edit, copies and moves included. Lets derived data tell it's out of date
+		uint64_t Version() const { return version; }
+
+	private:
+		Size size = { 0, 0 };
+		size_t cellCount = 0;
+		uint64_t* bits = nullptr;
+		std::vector<uint64_t> storage;
+		std::shared_ptr<void> owner; // Keeps borrowed bits alive
+		uint64_t version = 0;
+	};
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <vector>
+#include "bucketqueue.hpp"
+#include "grid.hpp"
+#include "search.hpp"
+#include "searchspace.hpp"
+
+namespace Pathfinding {
+	// Dijkstra limited to a rectangle of the map, one cluster or a few. Scratch memory is sized
+	// to the rectangle, not the map, and reused by every run
+	class ClusterSearch {
+	public:
+		ClusterSearch() = default;
+
+		// Longest side of the rectangles that will be searched
+		void Resize(uint size);
+
+		// Explores [x0, x1) x [y0, y1) from source. With a target it runs as A* and stops once it's reached
+		void Run(const Grid& grid, uint x0, uint y0, uint x1, uint y1, CellIndex source, CellIndex target = INVALID_CELL);
+
+		// Stops as soon as every one of the targets has its final cost
+		void RunToAll(const Grid& grid, uint x0, uint y0, uint x1, uint y1, CellIndex source, const CellIndex* targets,
+		              size_t targetCount);
+
+		// -1 when the cell wasn't reached. Only final for targets and after runs without any
+		int GetCost(CellIndex cell) const;
+
+		// Appends the cells after source up to and including target
+		void AppendPath(CellIndex target, std::vector<Position>& path) const;
+
+		// Counters summed over all runs since the last ResetStats
+		const SearchStats& GetStats() const { return stats.Get(); }
+		void ResetStats() { stats.Reset(); }
+
+	private:
+		const Grid* grid = nullptr;
+		uint x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+		uint stride = 0;
+
+		// Local cells have a ring of walls around the rectangle, so moves need no bounds checks
+		std::vector<int> cost;
+		std::vector<uint32_t> parent;
+		std::vector<uint32_t> stamp;
+		std::vector<uint32_t> targetStamp;
+		std::vector<uint8_t> walkable;
+		uint32_t generation = 0;
+		BucketQueue queue;
+		Stats stats;
+
+		void Explore(const Grid& grid, uint x0, uint y0, uint x1, uint y1, CellIndex source, const CellIndex* targets,
+		             size_t targetCount, bool toTarget);
+		bool Contains(CellIndex cell) const;
+		uint32_t Local(CellIndex cell) const;
+		CellIndex Global(uint32_t local) const;
+	};
+
+	// Abstract graph for hierarchical pathfinding (HPA*). The map is cut into square clusters,
+	// cells on both sides of every open stretch of cluster border become entrance nodes,
+	// and entrances of the same cluster are linked with their exact in-cluster path cost.
+	// Built once per map and read-only afterwards, so it can be shared between threads
+	class ClusterGraph {
+	public:
+		struct Edge {
+			uint32_t to;
+			int cost;
+		};
+
+		ClusterGraph() = default;
+
+		void Build(const Grid& grid, uint clusterSize = 16);
+		bool Empty() const { return grid == nullptr; }
+
+		const Grid& GetGrid() const { return *grid; }
+		uint ClusterSize() const { return clusterSize; }
+		uint ClusterOf(CellIndex cell) const;
+		void ClusterBounds(uint cluster, uint& x0, uint& y0, uint& x1, uint& y1) const;
+
+		size_t NodeCount() const { return nodeCells.size(); }
+		CellIndex NodeCell(uint32_t node) const { return nodeCells[node]; }
+
+		const Edge* EdgesBegin(uint32_t node) const { return edges.data() + edgeStart[node]; }
+		const Edge* EdgesEnd(uint32_t node) const { return edges.data() + edgeStart[node + 1]; }
+
+		const uint32_t* ClusterNodesBegin(uint cluster) const { return clusterNodes.data() + clusterNodeStart[cluster]; }
+		const uint32_t* ClusterNodesEnd(uint cluster) const { return clusterNodes.data() + clusterNodeStart[cluster + 1]; }
+
+	private:
+		const Grid* grid = nullptr;
+		uint clusterSize = 0;
+		uint clustersX = 0;
+		uint clustersY = 0;
+
+		std::vector<CellIndex> nodeCells;
+
+		// Adjacency and cluster membership in compressed sparse row form
+		std::vector<uint32_t> edgeStart;
+		std::vector<Edge> edges;
+		std::vector<uint32_t> clusterNodeStart;
+		std::vector<uint32_t> clusterNodes;
+	};
+
+	// Answers queries on a ClusterGraph. Each instance has its own scratch memory, use one per thread
+	class HierarchicalPathfinder {
+	public:
+		HierarchicalPathfinder(const ClusterGraph& graph);
+
+		// Searches the abstract graph, then refines each step of the corridor inside its cluster.
+		// Paths are near-optimal; use Search for exact ones. Ends in the same or touching clusters
+		// are also searched directly within the clusters around them, and the cheaper path wins.
+		// Falls back to a full grid search when the abstract graph finds nothing,
+		// because diagonal-only border crossings have no entrance.
+		// The stats cover the abstract search and every cluster search, setup is connecting start and end
+		PathResult Solve(CellIndex start, CellIndex end);
+
+	private:
+		const ClusterGraph& graph;
+
+		// Abstract nodes, plus one slot each for the query's start and end
+		SearchSpace space;
+		uint32_t startId;
+		uint32_t endId;
+		std::vector<ClusterGraph::Edge> startEdges;
+		std::vector<ClusterGraph::Edge> endEdges;
+
+		ClusterSearch clusterSearch;
+		ClusterSearch localSearch; // Up to 4x4 clusters around nearby ends
+		std::vector<CellIndex> targets;
+		Search fallback;
+		bool fallbackReady = false;
+		Stats stats;
+
+		// Links cell to the entrances of its cluster, and to the end when it's in the same cluster
+		void Connect(CellIndex cell, CellIndex end, std::vector<ClusterGraph::Edge>& links);
+		// Clusters around both ends when they're in the same or touching clusters
+		bool LocalWindow(CellIndex start, CellIndex end, uint& x0, uint& y0, uint& x1, uint& y1) const;
+		int Heuristic(CellIndex cell, CellIndex end) const;
+		CellIndex Cell(uint32_t node, CellIndex start, CellIndex end) const;
+	};
+}
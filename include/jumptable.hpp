@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "grid.hpp"
+
+namespace Pathfinding {
+	// Precomputed straight jump distances for JPS+. For every cell and straight direction:
+	//   > 0  steps to the next jump point
+	//   <= 0 minus the steps to the last walkable cell before a wall
+	//   FAR  neither within 32767 steps, move that far and look again
+	// The goal isn't known when building, searches check it themselves.
+	// Like Grid, the distances are either owned or borrowed from a memory-mapped file
+	class JumpTable {
+	public:
+		enum Direction {
+			East = 0, // +x
+			West,     // -x
+			South,    // +y
+			North     // -y
+		};
+
+		static constexpr int16_t FAR = INT16_MIN;
+		static constexpr int FAR_STEPS = INT16_MAX;
+
+		JumpTable() = default;
+
+		// Copies always own their distances, moves keep borrowed ones
+		JumpTable(const JumpTable& other);
+		JumpTable(JumpTable&& other) noexcept;
+		JumpTable& operator=(const JumpTable& other);
+		JumpTable& operator=(JumpTable&& other) noexcept;
+
+		// Owned from then on, also when it was borrowed before
+		void Build(const Grid& grid);
+		bool Empty() const { return count == 0; }
+
+		// Uses count distances stored somewhere else without copying them. owner is released with the table
+		void Attach(const int16_t* distances, size_t count, std::shared_ptr<void> owner);
+
+		int16_t Get(CellIndex cell, Direction direction) const { return distances[(size_t)cell * 4 + direction]; }
+
+		// Raw distances, four per cell in Direction order. Used to store prebuilt tables with the map
+		const int16_t* Data() const { return distances; }
+		size_t Size() const { return count; }
+
+		static Direction ToDirection(int dx, int dy) {
+			if(dx > 0) return East;
+			if(dx < 0) return West;
+			if(dy > 0) return South;
+			return North;
+		}
+
+	private:
+		const int16_t* distances = nullptr;
+		size_t count = 0;
+		std::vector<int16_t> storage;
+		std::shared_ptr<void> owner; // Keeps borrowed distances alive
+
+		void BuildLine(const Grid& grid, uint x, uint y, int dx, int dy, uint length, std::vector<int>& scratch);
+	};
+
+	// Cell outside the map counts as a wall
+	inline bool IsOpen(const Grid& grid, int x, int y) {
+		return grid.InBounds(x, y) && grid.IsWalkable(grid.Index(x, y));
+	}
+
+	// True when arriving at (x, y) moving straight along (dx, dy) uncovers a forced neighbour
+	inline bool IsStraightJumpPoint(const Grid& grid, int x, int y, int dx, int dy) {
+		if(dy == 0) {
+			return (!IsOpen(grid, x, y + 1) && IsOpen(grid, x + dx, y + 1))
+				|| (!IsOpen(grid, x, y - 1) && IsOpen(grid, x + dx, y - 1));
+		}
+		return (!IsOpen(grid, x + 1, y) && IsOpen(grid, x + 1, y + dy))
+			|| (!IsOpen(grid, x - 1, y) && IsOpen(grid, x - 1, y + dy));
+	}
+}
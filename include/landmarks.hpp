@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "grid.hpp"
+
+namespace Pathfinding {
+	// ALT (A*, landmarks, triangle inequality) heuristic. Exact path costs from a few landmark
+	// cells to every cell bound the cost between any two cells from below:
+	//   cost(a, b) >= |cost(L, a) - cost(L, b)|
+	// Much tighter than octile distance on mazes and corridors, where it's off by the detours.
+	// Costs are 16 bit per cell and landmark, scaled down for landmarks whose longest one doesn't fit
+	class Landmarks {
+	public:
+		static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+
+		Landmarks() = default;
+
+		// Landmarks are spread around the map border, snapped to the nearest floor.
+		// One Dijkstra per landmark, split between threads. threadCount 0 uses every hardware thread
+		void Build(const Grid& grid, uint count = 8, uint threadCount = 0);
+		bool Empty() const { return landmarks.empty(); }
+
+		// Lowers the costs a wall removed at the cell shortened, with one Dijkstra per landmark that
+		// only visits those cells. False when the tables are scaled or a new cost doesn't fit,
+		// they are then partly updated and have to be built again before use
+		bool Open(const Grid& grid, CellIndex cell);
+
+		uint Count() const { return (uint)landmarks.size(); }
+		CellIndex GetLandmark(uint index) const { return landmarks[index]; }
+
+		// True when no table had to be scaled. Otherwise the bound is rounded down
+		// and no longer consistent, searches then have to reopen closed cells
+		bool Exact() const { return exact; }
+
+		// Admissible lower bound on the path cost between the cells, 0 if no landmark reaches both
+		int LowerBound(CellIndex cellA, CellIndex cellB) const {
+			const uint16_t* a = &distances[(size_t)cellA * landmarks.size()];
+			const uint16_t* b = &distances[(size_t)cellB * landmarks.size()];
+			int best = 0;
+			for(size_t i = 0; i < landmarks.size(); i++) {
+				if(a[i] == UNREACHABLE || b[i] == UNREACHABLE) continue;
+				int difference = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+				// Rounded costs can each be off by almost one unit
+				if(!exact) difference = difference > 0 ? (difference - 1) * (int)scales[i] : 0;
+				if(difference > best) best = difference;
+			}
+			return best;
+		}
+
+	private:
+		std::vector<CellIndex> landmarks;
+		std::vector<uint16_t> distances; // Landmarks of a cell are next to each other
+		std::vector<uint> scales; // Path cost per stored unit, per landmark
+		bool exact = true;
+
+		CellIndex NearestFloor(const Grid& grid, uint x, uint y) const;
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <string>
+#include "grid.hpp"
+#include "jumptable.hpp"
+#include "terrain.hpp"
+
+namespace Pathfinding {
+	// Walkability grid plus the start and end marked in the source image
+	struct MapData {
+		Grid grid;
+		TerrainCosts costs; // Empty unless loaded with a palette
+		JumpTable jumpTable; // Prebuilt JPS+ distances stored with a compact map, usually empty
+		CellIndex start = INVALID_CELL;
+		CellIndex end = INVALID_CELL;
+	};
+
+	// Floor is white, start blue, end red. Everything else is a wall.
+	// With a palette its colors are terrain of the given cost and the rest still cost 1,
+	// a palette entry for white overrides the floor cost.
+	// Works with any pixel type that has red, green and blue members (e.g. Drawpp's Color)
+	template <typename Pixel>
+	MapData ClassifyPixels(const Pixel* pixels, uint width, uint height, const TerrainPalette* palette = nullptr) {
+		MapData map;
+		map.grid.Resize(width, height);
+		bool weighted = palette != nullptr && !palette->empty();
+		if(weighted) {
+			map.costs.Resize(map.grid.CellCount());
+		}
+
+		for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+			const Pixel& pixel = pixels[cell];
+			bool start = pixel.red == 0 && pixel.green == 0 && pixel.blue == 255;
+			bool end = pixel.red == 255 && pixel.green == 0 && pixel.blue == 0;
+
+			// Terrain. Start and end are always plain floor
+			if(weighted && !start && !end) {
+				auto terrain = std::find_if(palette->begin(), palette->end(), [&](const TerrainType& type) {
+					return pixel.red == type.red && pixel.green == type.green && pixel.blue == type.blue;
+				});
+				if(terrain != palette->end()) {
+					map.grid.SetWalkable(cell, terrain->cost != 0);
+					map.costs.Set(cell, terrain->cost);
+					continue;
+				}
+			}
+
+			// Floor
+			if( pixel.red == 255 && pixel.green == 255 && pixel.blue == 255 ) {
+				map.grid.SetWalkable(cell, true);
+			}
+			// Start
+			else if( start ) {
+				map.start = cell;
+				map.grid.SetWalkable(cell, true);
+			}
+			// End
+			else if( end ) {
+				map.end = cell;
+				map.grid.SetWalkable(cell, true);
+			}
+			// Walls stay unwalkable
+
+			if(weighted) {
+				map.costs.Set(cell, map.grid.IsWalkable(cell) ? 1 : 0);
+			}
+		}
+		return map;
+	}
+
+	// Loads an uncompressed 24 or 32 bit BMP without any graphics library
+	bool LoadBitmap(const std::string& path, MapData& map, const TerrainPalette* palette = nullptr);
+
+	// Compact map files (.pfmap), little-endian:
+	//   64 byte header: magic "PFMAP\0\0\0", version, width, height, start, end, flags,
+	//                   offset of the walkability bits, offset of the jump table or 0
+	//   walkability bits in Grid::Bits layout, 8 byte aligned
+	//   optional JumpTable distances, four int16 per cell
+	// Terrain costs aren't stored, compact maps are uniform cost
+	bool SaveCompactMap(const std::string& path, const MapData& map, const JumpTable* jumpTable = nullptr);
+
+	// Memory-maps the file and uses its bits as the grid directly, nothing is parsed or copied.
+	// The mapping is private, so wall edits never reach the file.
+	// A stored jump table is borrowed from the mapping the same way
+	bool LoadCompactMap(const std::string& path, MapData& map);
+
+	// Either format, told apart by the first bytes of the file. The palette only applies to bitmaps
+	bool LoadMap(const std::string& path, MapData& map, const TerrainPalette* palette = nullptr);
+}
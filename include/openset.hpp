@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "grid.hpp"
+#include "zeroedarray.hpp"
+
+namespace Pathfinding {
+	// Indexed binary min-heap of cells ordered by fCost, ties broken on hCost.
+	// Keys are stored inline with the cell so comparisons don't chase other arrays,
+	// and every cell remembers its own slot so membership tests are O(1)
+	// and decrease-key doesn't need a search. Slots are stored one up so the zeroed
+	// array reads as an empty heap without being written.
+	class OpenSet {
+	public:
+		OpenSet() = default;
+
+		// Must be called with the map's cell count before use
+		void Resize(size_t cellCount);
+
+		void Push(CellIndex cell, int fCost, int hCost);
+		CellIndex Pop();
+		CellIndex Top();
+
+		// Restore heap order after cell's cost has been lowered
+		void DecreaseKey(CellIndex cell, int fCost, int hCost);
+
+		// Change the key in either direction
+		void Update(CellIndex cell, int fCost, int hCost);
+		void Remove(CellIndex cell);
+
+		int TopFCost() const { return heap.front().fCost; }
+		int TopHCost() const { return heap.front().hCost; }
+		// Cell must be queued
+		int GetFCost(CellIndex cell) const { return heap[slots[cell] - 1].fCost; }
+
+		bool Contains(CellIndex cell) const { return slots[cell] != NOT_IN_HEAP; }
+		bool Empty() const { return heap.empty(); }
+		size_t Size() const { return heap.size(); }
+
+		void Clear();
+
+	private:
+		struct Entry {
+			int fCost;
+			int hCost;
+			CellIndex cell;
+		};
+
+		static constexpr uint32_t NOT_IN_HEAP = 0;
+
+		std::vector<Entry> heap;
+		ZeroedArray<uint32_t> slots; // Heap index + 1 of each cell
+
+		bool Less(const Entry& a, const Entry& b) const {
+			if(a.fCost != b.fCost) {
+				return a.fCost < b.fCost;
+			}
+			// Prefer cells closer to the goal when tied
+			return a.hCost < b.hCost;
+		}
+		void Place(const Entry& entry, size_t index);
+		void SiftUp(size_t index);
+		void SiftDown(size_t index);
+	};
+}
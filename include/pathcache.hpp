@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "grid.hpp"
+#include "policies.hpp"
+#include "search.hpp"
+#include "terrain.hpp"
+
+namespace Pathfinding {
+	// Bounded LRU cache of found paths, safe to share between threads.
+	// Paths are stored as run-length encoded moves, one byte per run of up to 32 equal steps.
+	// Every part of an optimal path is optimal too, so a query whose start and end both lie on a
+	// cached path, in that order, is answered by slicing it. Paths are only reused in the direction
+	// they were found in, terrain costs make moves one-way.
+	// Edits bump the map version. A new wall drops the paths through it, a new floor cell drops
+	// the paths that could get shorter through it. Results found against an older version aren't stored
+	class PathCache {
+	public:
+		// capacity is in paths, 0 turns the cache off
+		explicit PathCache(size_t capacity = 4096);
+
+		PathCache(const PathCache&) = delete;
+		PathCache& operator=(const PathCache&) = delete;
+
+		// Clears the cache
+		void SetGrid(const Grid* grid);
+		void SetCapacity(size_t capacity);
+
+		// Moves and terrain of the search the paths come from, sliced paths are priced with them.
+		// Both clear the cache
+		void SetPolicy(SearchPolicy policy);
+		void SetCosts(const TerrainCosts* costs);
+
+		void Clear();
+
+		// Fills result from a cached path between the cells, or a part of one. Search stats are left empty
+		bool Lookup(CellIndex start, CellIndex end, PathResult& result);
+
+		// version is Version() from before the search started. Paths that aren't found aren't stored
+		void Store(CellIndex start, CellIndex end, uint64_t version, const PathResult& result);
+
+		// Call after changing the cell in the grid
+		void SetWalkable(CellIndex cell, bool walkable);
+
+		uint64_t Version() const;
+		size_t Size() const;
+		uint64_t Hits() const;
+		uint64_t Misses() const;
+
+	private:
+		static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+		struct Entry {
+			CellIndex start = INVALID_CELL;
+			CellIndex end = INVALID_CELL;
+			int cost = 0;
+			uint32_t cellCount = 0;
+			std::vector<uint8_t> runs; // Direction in the low 3 bits, run length - 1 in the high 5
+			// Least recently used list, empty slots have no runs
+			uint32_t newer = NO_SLOT;
+			uint32_t older = NO_SLOT;
+		};
+
+		// A cached path going through a cell, position counts cells from its start
+		struct PathRef {
+			uint32_t slot;
+			uint32_t position;
+		};
+
+		mutable std::mutex mutex;
+		const Grid* grid = nullptr;
+		SearchPolicy policy;
+		const TerrainCosts* costs = nullptr;
+		size_t capacity;
+		uint64_t version = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+
+		std::vector<Entry> entries;
+		std::vector<uint32_t> freeSlots;
+		uint32_t newest = NO_SLOT;
+		uint32_t oldest = NO_SLOT;
+		// Paths through each cell. Takes more memory than the encoded paths, but finds
+		// the paths to slice and to drop on edits without decoding any
+		std::unordered_map<CellIndex, std::vector<PathRef>> cells;
+		std::vector<uint32_t> startPositions; // Lookup scratch, per slot
+
+		// Slot and positions of a cached path from start to end, false if there is none
+		bool Find(CellIndex start, CellIndex end, uint32_t& slot, uint32_t& first, uint32_t& last);
+		void Touch(uint32_t slot);
+		void Unlink(uint32_t slot);
+		void Remove(uint32_t slot);
+		void ClearLocked();
+		// Calls visit(cell, position) for the cells of the path
+		template <class Visit>
+		void ForEachCell(const Entry& entry, Visit&& visit) const;
+		// Lowest cost any path between the cells could have
+		int LowerBound(CellIndex from, CellIndex to) const;
+	};
+}
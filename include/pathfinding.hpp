@@ -1,93 +1,108 @@
 #pragma once
-#include <drawpp.hpp>
+#include <vector>
+#include "dstarlite.hpp"
+#include "flowfield.hpp"
+#include "grid.hpp"
+#include "mapio.hpp"
+#include "pathcache.hpp"
+#include "search.hpp"
 
 namespace Pathfinding {
-	struct Position {
-		uint x;
-		uint y;
-
-		bool operator ==(const Position& pos) {
-			if(x == pos.x && y == pos.y) {
-				return true;
-			}
-			return false;
-		};
-
-		bool operator !=(const Position& pos) {
-			if(x != pos.x || y != pos.y) {
-				return true;
-			}
-			return false;
-		};
-	};
-	struct Size {
-		uint width;
-		uint height;
-	};
-
-	class Node {
+	class Pathfinder {
 	public:
-		Position pos;
-		Color* pixel; // TODO Don't use drawpp as dependency
-		uint tested = 0; // TODO DEBUG
+		Pathfinder() = default;
+		Pathfinder(const Pathfinder&) = delete; // search keeps a pointer to our grid
+		Pathfinder& operator=(const Pathfinder&) = delete;
 
+		// Takes the map over. Pass it with std::move to keep a memory-mapped grid and jump table
+		// borrowed from the file instead of copying them
+		void SetData(MapData map);
 
-		Node *parent = nullptr;
+		// Restarts the current search with the new algorithm
+		void SetAlgorithm(Algorithm algorithm);
+		Algorithm GetAlgorithm() { return algorithm; }
 
-		int gCost = 0;
-		int hCost = 0;
+		// Movement rules and heuristic of the grid searches. Restarts the current search.
+		// Incremental mode keeps 8-way octile moves. Components are labelled for the policy's moves,
+		// without diagonals past corners Incremental mode searches even when start and end are walled off
+		void SetPolicy(SearchPolicy policy);
+		SearchPolicy GetPolicy() const { return search.GetPolicy(); }
 
-		Node(uint _posX, uint _posY, Color* _px) {
-			pos.x = _posX;
-			pos.y = _posY;
-			pixel = _px;
-		}
+		// ALT heuristic with the given number of landmarks for the grid searches, 0 turns it off.
+		// Removed walls can shorten paths, the costs they change are lowered in place
+		void SetLandmarks(uint count);
 
-		int fCost() {
-			return gCost + hCost;
-		}
-	};
+		// Expands one cell
+		Position DoStep();
 
+		// Expands cells until the budget is spent or the path is known, and returns the last one.
+		// Anytime mode goes on improving its path after finding one and returns the end meanwhile
+		Position Step(const StepBudget& budget);
 
-	class Pathfinder {
-	public:
-		Pathfinder() = default;
+		// First Anytime paths cost at most this times the optimal one. Restarts the current search
+		void SetAnytimeWeight(double weight);
 
-		void SetData(std::vector<Pathfinding::Node*> data);
+		// Runs a whole search from start to end without stepping.
+		// Ends at once without a path when they are in different components.
+		// Anytime mode returns its first path. Other than in Incremental and Anytime mode,
+		// answers from the path cache when it can
+		PathResult FindPath(Position start, Position end);
 
-		Node* DoStep();
+		// Paths kept for FindPath, 0 turns the cache off. Emptied by SetData and SetPolicy
+		void SetCacheCapacity(size_t capacity) { cache.SetCapacity(capacity); }
+		const PathCache& GetCache() const { return cache; }
+
+		// Distances and directions from every cell to the end, for many agents sharing it.
+		// Built on first use and again after the end or a wall changes
+		const FlowField& GetFlowField();
 
-		void SetMapSize(uint width, uint height);
 		Size GetMapSize();
+		const Grid& GetGrid() { return grid; }
+		// Empty for uniform cost maps. Incremental mode, flow fields and HPA* ignore terrain
+		const TerrainCosts& GetCosts() { return costs; }
+
+		// Path from the given cell back to the start. In Incremental mode it goes towards the end instead
+		std::vector<Position> RetracePath(Position endPos);
 
-		std::vector<Node*> RetracePath(Node* endNode);
+		// Turns a cell into a wall or floor. Incremental mode repairs its search, others restart
+		void SetWalkable(uint x, uint y, bool walkable);
 
-		Node* GetNode(uint x, uint y);
+		NodeState GetNodeState(uint x, uint y);
 
+		// Counters of the current search, or of the latest replan in Incremental mode
+		const SearchStats& GetStats() const;
+
+		// Restarts the search. In Incremental mode only replans what changed
 		void ResetPath();
 
-		Node* MoveStart(uint x, uint y);
-		Node* MoveEnd(uint x, uint y);
+		Position MoveStart(uint x, uint y);
+		Position MoveEnd(uint x, uint y);
 		Position GetStartNodePosition();
 		Position GetEndNodePosition();
 
 		bool pathFound = false;
+		bool noPath = false; // Start and end are walled off from each other
 
 	private:
-		Size mapSize;
-
-		Node* startNode;
-		Node* endNode;
-
-		std::vector<Pathfinding::Node*> pathdata;
-		std::vector<Pathfinding::Node*> openSet;
-		std::vector<Pathfinding::Node*> closedSet;
-
-		std::vector<Node*> GetNeighbourNodes(Node* node);
-
-		int GetDistance(Node *nodeA, Node *nodeB);
-
-		Node* GetStartNode();
-		Node* GetEndNode();
+		Grid grid;
+		TerrainCosts costs;
+		Search search;
+		JumpTable jumpTable; // From the map or built on first use of JumpPointSearchPlus
+		Components components;
+		Landmarks landmarks;
+		uint landmarkCount = 0;
+		bool landmarksStale = false; // Scaled tables wait for the next FindPath after a wall is removed
+		FlowField flowField;
+		bool flowFieldStale = true;
+		PathCache cache{ 1024 };
+
+		Algorithm algorithm = AStar;
+		DStarLite dstar;
+		bool dstarReady = false;
+
+		CellIndex startNode = INVALID_CELL;
+		CellIndex endNode = INVALID_CELL;
+
+		bool Separated() const;
 	};
 }
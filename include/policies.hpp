@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include "grid.hpp"
+#include "jumptable.hpp"
+
+namespace Pathfinding {
+	enum Connectivity : uint8_t {
+		EightWay,          // Diagonal moves may cut past wall corners
+		EightWayNoCorners, // Diagonal moves need both cells beside them open
+		FourWay
+	};
+
+	enum CostModel : uint8_t {
+		OctileCost, // 10 straight, 14 diagonal
+		UniformCost // 10 for every move
+	};
+
+	enum Metric : uint8_t {
+		Octile,
+		Manhattan,
+		Chebyshev,
+		Euclidean // Scaled so a diagonal step is 14
+	};
+
+	// Movement rules and heuristic of a search. Combinations that keep paths optimal:
+	//   FourWay: any metric, Manhattan is exact on open ground
+	//   EightWay(NoCorners) with OctileCost: Octile (exact on open ground), Chebyshev, Euclidean
+	//   EightWay(NoCorners) with UniformCost: Chebyshev
+	// Other combinations overestimate and return longer paths, but faster
+	struct SearchPolicy {
+		Connectivity connectivity = EightWay;
+		CostModel cost = OctileCost;
+		Metric metric = Octile;
+
+		bool operator==(const SearchPolicy& other) const = default;
+	};
+
+	// Compile-time versions of the above, one search kernel is instantiated per combination
+	namespace Policy {
+		struct Move {
+			int dx;
+			int dy;
+		};
+
+		template <Connectivity C>
+		struct Moves {
+			static constexpr int COUNT = 8;
+			static constexpr Move MOVES[8] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+
+			// Target cell is known to be open. Map is a Grid or anything else with an IsOpen overload
+			template <class Map>
+			static bool Allowed(const Map& grid, int x, int y, Move move) {
+				if constexpr(C == EightWayNoCorners) {
+					return move.dx == 0 || move.dy == 0 || (IsOpen(grid, x + move.dx, y) && IsOpen(grid, x, y + move.dy));
+				}
+				return true;
+			}
+		};
+
+		template <>
+		struct Moves<FourWay> {
+			static constexpr int COUNT = 4;
+			static constexpr Move MOVES[4] = { {-1, 0}, {0, -1}, {0, 1}, {1, 0} };
+
+			template <class Map>
+			static bool Allowed(const Map&, int, int, Move) { return true; }
+		};
+
+		template <CostModel M>
+		struct Cost {
+			static constexpr int STRAIGHT = 10;
+			static constexpr int DIAGONAL = M == OctileCost ? 14 : 10;
+
+			static constexpr int Of(Move move) { return move.dx != 0 && move.dy != 0 ? DIAGONAL : STRAIGHT; }
+		};
+
+		// Estimate for absolute coordinate differences
+		template <Metric H>
+		struct Distance {
+			static int Get(int dx, int dy) {
+				int low = std::min(dx, dy);
+				int high = std::max(dx, dy);
+				if constexpr(H == Octile) return 14 * low + 10 * (high - low);
+				if constexpr(H == Manhattan) return 10 * (dx + dy);
+				if constexpr(H == Chebyshev) return 10 * high;
+				// Just under 7 * sqrt(2) per cell keeps a step below 10 straight and 14 diagonal
+				// even after floating point error, so the rounded down estimate stays consistent
+				return (int)(std::sqrt((double)dx * dx + (double)dy * dy) * 9.8994);
+			}
+		};
+
+		// WEIGHTED kernels multiply move costs by TerrainCosts and queue cells in buckets
+		template <Connectivity C, CostModel M, Metric H, bool WEIGHTED_>
+		struct Kernel {
+			typedef Policy::Moves<C> Moves;
+			typedef Policy::Cost<M> Cost;
+			typedef Policy::Distance<H> Distance;
+
+			static constexpr bool WEIGHTED = WEIGHTED_;
+			// Landmark costs are 8-way octile ones, never more than any path with these moves costs
+			static constexpr bool LANDMARKS = M == OctileCost;
+			// Jump point search prunes for exactly these moves on uniform cost
+			static constexpr bool JUMPS = C == EightWay && M == OctileCost && !WEIGHTED;
+
+			// Calls visit(move) for every move, unrolled
+			template <class Visit>
+			static void ForEachMove(Visit&& visit) {
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					(visit(Moves::MOVES[I]), ...);
+				}(std::make_index_sequence<Moves::COUNT>{});
+			}
+		};
+
+		constexpr size_t KERNEL_COUNT = 3 * 2 * 4 * 2;
+
+		constexpr size_t KernelIndex(SearchPolicy policy, bool weighted) {
+			return (size_t)weighted * 24 + (size_t)policy.connectivity * 8 + (size_t)policy.cost * 4 + (size_t)policy.metric;
+		}
+
+		template <size_t I>
+		using KernelAt = Kernel<(Connectivity)(I % 24 / 8), (CostModel)(I / 4 % 2), (Metric)(I % 4), (I >= 24)>;
+	}
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <vector>
+#include "components.hpp"
+#include "grid.hpp"
+#include "jumptable.hpp"
+#include "landmarks.hpp"
+#include "policies.hpp"
+#include "searchspace.hpp"
+#include "stats.hpp"
+#include "terrain.hpp"
+
+namespace Pathfinding {
+	struct PathResult {
+		bool found = false;
+		int cost = 0;
+		std::vector<Position> path; // From start to end
+		SearchStats stats;
+	};
+
+	enum Algorithm {
+		AStar,
+		JumpPointSearch,     // Expands only jump points, same path costs as AStar
+		JumpPointSearchPlus, // JPS with straight jumps read from a precomputed JumpTable
+		Incremental,         // D* Lite, replans after start moves and wall edits. Pathfinder only
+		Bidirectional,       // A* from both ends at once, stops once no cheaper meeting point can exist
+		Anytime              // Weighted A*. The first path costs at most the weight times the optimal one,
+		                     // stepping on after it finds cheaper ones until the last is proven optimal
+	};
+
+	// Work one stepping call may do. A zero field sets no limit, at least one cell is always expanded
+	struct StepBudget {
+		uint64_t expansions = 0;
+		std::chrono::nanoseconds time{ 0 };
+	};
+
+	// Spends a StepBudget one expansion at a time. Reads the clock only every 32 expansions
+	class BudgetTracker {
+	public:
+		explicit BudgetTracker(const StepBudget& _budget)
+			: budget(_budget), deadline(std::chrono::steady_clock::now() + _budget.time) {}
+
+		// Counts an expansion. False once there's nothing left for another
+		bool Spend() {
+			spent++;
+			if(budget.expansions != 0 && spent >= budget.expansions) return false;
+			return budget.time.count() == 0 || spent % 32 != 0 || std::chrono::steady_clock::now() < deadline;
+		}
+
+	private:
+		StepBudget budget;
+		std::chrono::steady_clock::time_point deadline;
+		uint64_t spent = 0;
+	};
+
+	// A* over a read-only grid. The grid can be shared by any number of searches,
+	// each search owns its own SearchSpace
+	class Search {
+	public:
+		Search() = default;
+
+		void SetGrid(const Grid* grid);
+
+		// JumpPointSearchPlus needs a table built from the same grid
+		void SetAlgorithm(Algorithm algorithm, const JumpTable* jumpTable = nullptr);
+		Algorithm GetAlgorithm() const { return algorithm; }
+
+		// Movement rules and heuristic. Each combination runs its own compiled kernel.
+		// Jump point search needs EightWay moves with OctileCost and runs as AStar otherwise
+		void SetPolicy(SearchPolicy policy);
+		SearchPolicy GetPolicy() const { return policy; }
+
+		// How much Anytime mode trusts the heuristic at first, 1 or more. Applies from the next Begin
+		void SetAnytimeWeight(double weight);
+
+		// Per-cell cost multipliers of the same grid, nullptr for uniform cost. Weighted searches
+		// queue cells in buckets instead of a heap and run jump point search as AStar
+		void SetCosts(const TerrainCosts* costs);
+
+		// With labels of the same grid, queries between different components end
+		// before expanding anything: Solve returns no path and Begin leaves the open set empty.
+		// 4-connected labels are ignored while the policy allows diagonal moves past corners
+		void SetComponents(const Components* components);
+
+		// Tightens the heuristic with landmark costs of the same grid. Paths stay optimal.
+		// With scaled tables closed cells are reopened when a cheaper way to them turns up.
+		// Ignored with UniformCost, the 8-way octile costs of the tables would overestimate
+		void SetLandmarks(const Landmarks* landmarks);
+
+		// Prepares a new search. Cost doesn't depend on map size
+		void Begin(CellIndex start, CellIndex end);
+
+		// Expands the best open cell and returns it. INVALID_CELL when the open set is empty
+		CellIndex Step();
+
+		// Steps until the budget is spent or Finished. Returns the last cell expanded
+		CellIndex Step(const StepBudget& budget);
+
+		// Steps until the end is reached or the open set runs out. Anytime mode stops at its first path
+		bool Run();
+
+		// In Anytime mode the path is the first one found, within the weight of optimal
+		PathResult Solve(CellIndex start, CellIndex end);
+
+		// Cells from the given one back to the start. Gaps between jump points are filled in.
+		// In Bidirectional mode cells only reached from the end lead to the end instead,
+		// and once found the end's path runs through the meeting cell
+		std::vector<Position> RetracePath(CellIndex cell) const;
+
+		bool Found() const { return found; }
+		bool Exhausted() const;
+		// Further steps can't change the result. Anytime paths are final once the open set runs out
+		bool Finished() const { return algorithm == Anytime ? Exhausted() : found || Exhausted(); }
+
+		// Bidirectional mode reports the more advanced of the two searches
+		NodeState GetState(CellIndex cell) const;
+		// Only meaningful for cells the search reached
+		int GetGCost(CellIndex cell) const { return space.gCost[cell]; }
+
+		CellIndex GetStart() const { return startNode; }
+		CellIndex GetEnd() const { return endNode; }
+
+		// Counters since the last Begin. Phase times are only filled in by Solve
+		const SearchStats& GetStats() const { return stats.Get(); }
+
+	private:
+		// One instantiation of the templated search per SearchPolicy
+		struct Kernel {
+			CellIndex (Search::*step)();
+			CellIndex (Search::*stepBidirectional)();
+			CellIndex (Search::*stepJumpPoints)();
+			CellIndex (Search::*stepAnytime)();
+			int (Search::*heuristic)(CellIndex cell, CellIndex target) const;
+			bool jumps; // Runs jump point search, the rest run its modes as AStar
+		};
+		static const std::array<Kernel, Policy::KERNEL_COUNT> KERNELS;
+		template <class K>
+		static constexpr Kernel MakeKernel();
+
+		const Grid* grid = nullptr;
+		SearchSpace space;
+		SearchSpace backSpace; // Search from the end in Bidirectional mode, allocated on first use
+		// The grid transposed, so vertical jumps scan 64 cells at a time like horizontal ones.
+		// Built when jump point search first needs it and again after the grid changes
+		Grid columns;
+		uint64_t columnsVersion = UINT64_MAX;
+
+		Algorithm algorithm = AStar;
+		const JumpTable* jumpTable = nullptr;
+		const Components* components = nullptr;
+		const Landmarks* landmarks = nullptr;
+		const TerrainCosts* costs = nullptr;
+		int heuristicScale = 1; // Cheapest terrain cost
+		int anytimeWeight = 32; // In sixteenths
+		bool reopenClosed = false;
+		SearchPolicy policy;
+		const Kernel* kernel = KERNELS.data();
+
+		CellIndex startNode = INVALID_CELL;
+		CellIndex endNode = INVALID_CELL;
+		bool found = false;
+		Stats stats;
+
+		// Cheapest start to end cost through a cell both searches reached, and that cell.
+		// Anytime mode keeps the cost of its latest path here
+		int bestCost = 0;
+		CellIndex meetNode = INVALID_CELL;
+
+		// Sizes the scratch memory the current settings need
+		void AllocateSpaces();
+		void UpdateReopening();
+		bool Separated(CellIndex start, CellIndex end) const;
+		void PushStart(SearchSpace& side, CellIndex cell, int hCost);
+
+		template <class K> CellIndex StepAStar();
+		template <class K> CellIndex StepBidirectional();
+		template <class K> CellIndex StepJumpPoints();
+		template <class K> CellIndex StepAnytime();
+		// Offers side a path to 'to' through 'from' costing 'cost'. True when it was the cheapest so far
+		template <class K> bool Relax(SearchSpace& side, CellIndex from, CellIndex to, int cost, CellIndex target);
+		std::vector<Position> RetraceChain(const SearchSpace& side, CellIndex cell, CellIndex root) const;
+
+		// Cells side can move to from cell and what each move costs. The backward search of
+		// Bidirectional mode pays for leaving cell, since the real move enters it
+		// Closed ones are skipped unless they may be reopened
+		template <class K> int GetNeighbourNodes(SearchSpace& side, CellIndex cell, CellIndex* neighbours, int* moveCosts);
+
+		// Jump point search successors, at most one per direction
+		int GetJumpPoints(CellIndex cell, CellIndex* successors);
+		CellIndex Jump(int x, int y, int dx, int dy);
+		CellIndex JumpStraight(int x, int y, int dx, int dy);
+		CellIndex JumpStraightTable(int x, int y, int dx, int dy);
+
+		// Octile cost of a straight or diagonal jump
+		int GetDistance(CellIndex cellA, CellIndex cellB) const;
+		template <class K> int Heuristic(CellIndex cell, CellIndex target) const;
+		template <class K> int Potential(CellIndex cell, CellIndex target) const;
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include "bucketqueue.hpp"
+#include "grid.hpp"
+#include "openset.hpp"
+#include "zeroedarray.hpp"
+
+namespace Pathfinding {
+	enum NodeState : uint8_t {
+		Unvisited = 0,
+		Open,
+		Closed
+	};
+
+	// Reusable per-search scratch memory, per-cell data as structure of arrays.
+	// Each cell keeps one stamp, the search generation plus its state in that search. Generations
+	// step by two, so every stamp of an older search reads as Unvisited and starting a new search
+	// is O(1) instead of clearing every array. gCost and parent are only valid for visited cells.
+	// The arrays are zeroed pages committed as the search reaches them, so a short query on a huge
+	// map only pays for the cells around it
+	class SearchSpace {
+	public:
+		SearchSpace() = default;
+
+		void Resize(size_t cellCount);
+		void Reset();
+
+		NodeState GetState(CellIndex cell) const {
+			uint32_t cellStamp = stamp[cell];
+			return cellStamp > currentGeneration ? (NodeState)(cellStamp - currentGeneration) : Unvisited;
+		}
+		void SetState(CellIndex cell, NodeState state) { stamp[cell] = currentGeneration + state; }
+
+		size_t CellCount() const { return stamp.size(); }
+
+		// Allocates the bucket queue, used instead of the heap by searches over terrain costs
+		void UseBuckets();
+
+		// Only one of the two queues is used at a time, the other stays empty
+		bool OpenEmpty() const { return openSet.Empty() && buckets.Empty(); }
+		size_t OpenSize() const { return openSet.Size() + buckets.Size(); }
+
+		ZeroedArray<int> gCost;
+		ZeroedArray<CellIndex> parent;
+
+		OpenSet openSet;
+		BucketQueue buckets;
+
+	private:
+		ZeroedArray<uint32_t> stamp;
+		uint32_t currentGeneration = 0;
+	};
+}
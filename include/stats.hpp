@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Set to 0 (CMake option PATHFINDING_STATS=OFF) to compile all counting out
+#ifndef PATHFINDING_STATS
+#define PATHFINDING_STATS 1
+#endif
+
+namespace Pathfinding {
+	// Work done by one query. Everything stays zero when stats are compiled out
+	struct SearchStats {
+		uint64_t nodesExpanded = 0;
+		uint64_t nodesGenerated = 0; // Successors looked at, whether they improved or not
+		uint64_t openSetPeak = 0;
+		uint64_t heapPushes = 0;
+		uint64_t heapPops = 0;
+		uint64_t heapUpdates = 0;    // Decrease-key and other key changes
+		uint64_t reopened = 0;       // Closed nodes put back in the open set
+
+		// Wall-clock per phase in nanoseconds. Only whole-query calls like Solve are timed
+		uint64_t setupNs = 0;
+		uint64_t searchNs = 0;
+		uint64_t pathNs = 0;         // Retracing or refining the path
+
+		// Sums the counters of searches that ran one after another. The peak is the larger one
+		SearchStats& operator+=(const SearchStats& other) {
+			nodesExpanded += other.nodesExpanded;
+			nodesGenerated += other.nodesGenerated;
+			openSetPeak = std::max(openSetPeak, other.openSetPeak);
+			heapPushes += other.heapPushes;
+			heapPops += other.heapPops;
+			heapUpdates += other.heapUpdates;
+			reopened += other.reopened;
+			setupNs += other.setupNs;
+			searchNs += other.searchNs;
+			pathNs += other.pathNs;
+			return *this;
+		}
+	};
+
+	template <bool Enabled>
+	class StatsRecorder {
+	public:
+		typedef std::chrono::steady_clock::time_point TimePoint;
+
+		void Reset() { stats = SearchStats(); }
+		const SearchStats& Get() const { return stats; }
+
+		void Expanded() { stats.nodesExpanded++; }
+		void Generated() { stats.nodesGenerated++; }
+		void Pushed(size_t openSetSize) {
+			stats.heapPushes++;
+			stats.openSetPeak = std::max<uint64_t>(stats.openSetPeak, openSetSize);
+		}
+		void Popped() { stats.heapPops++; }
+		void Updated() { stats.heapUpdates++; }
+		void Reopened() { stats.reopened++; }
+
+		TimePoint Now() const { return std::chrono::steady_clock::now(); }
+		// Adds the time since start to one of the phase fields, e.g. &SearchStats::searchNs
+		void AddTime(uint64_t SearchStats::*phase, TimePoint start) {
+			stats.*phase += std::chrono::duration_cast<std::chrono::nanoseconds>(Now() - start).count();
+		}
+
+	private:
+		SearchStats stats;
+	};
+
+	// Compiled-out version, every call is an empty inline function
+	template <>
+	class StatsRecorder<false> {
+	public:
+		struct TimePoint {};
+
+		void Reset() {}
+		const SearchStats& Get() const { return empty; }
+
+		void Expanded() {}
+		void Generated() {}
+		void Pushed(size_t) {}
+		void Popped() {}
+		void Updated() {}
+		void Reopened() {}
+
+		TimePoint Now() const { return TimePoint(); }
+		void AddTime(uint64_t SearchStats::*, TimePoint) {}
+
+	private:
+		static constexpr SearchStats empty = SearchStats();
+	};
+
+	typedef StatsRecorder<PATHFINDING_STATS != 0> Stats;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "grid.hpp"
+
+namespace Pathfinding {
+	// Map color of a terrain type and how much entering it costs, as a multiple of plain floor.
+	// Cost 0 makes the color a wall
+	struct TerrainType {
+		uint8_t red;
+		uint8_t green;
+		uint8_t blue;
+		uint8_t cost;
+	};
+	typedef std::vector<TerrainType> TerrainPalette;
+
+	// Reads one "red green blue cost" entry per line. Blank lines and lines starting with # are skipped
+	bool LoadPalette(const std::string& path, TerrainPalette& palette);
+
+	// Cost multiplier per cell, one byte each. Entering a cell costs the move (10 straight, 14 diagonal)
+	// times its multiplier, so plain floor is 1. Walkable cells need at least 1, walls are 0
+	class TerrainCosts {
+	public:
+		TerrainCosts() = default;
+
+		// Every cell starts at 0
+		void Resize(size_t cellCount);
+		bool Empty() const { return costs.empty(); }
+		size_t CellCount() const { return costs.size(); }
+
+		uint8_t Get(CellIndex cell) const { return costs[cell]; }
+		void Set(CellIndex cell, uint8_t cost) {
+			costs[cell] = cost;
+			if(cost != 0 && cost < minCost) minCost = cost;
+		}
+
+		// Never more than the cheapest walkable cell, heuristics are scaled by it.
+		// Raising the cheapest cell doesn't raise it back
+		uint8_t MinCost() const { return minCost; }
+
+		const uint8_t* Data() const { return costs.data(); }
+
+	private:
+		std::vector<uint8_t> costs;
+		uint8_t minCost = UINT8_MAX;
+	};
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "grid.hpp"
+#include "mapio.hpp"
+
+namespace Pathfinding {
+	// Tiled map files (.pftiles) for maps too big for memory, little-endian:
+	//   64 byte header: magic "PFTILES\0", version, width, height, tile size,
+	//                   start x and y, end x and y, offset of the first tile
+	//   tiles row by row, each one tile size squared bits in Grid::Bits layout
+	// Tile size is a power of two of at least 64, so a tile is whole words. Cells past the map edge are walls.
+	// Coordinates of a missing start or end are UINT32_MAX
+	bool SaveTiledMap(const std::string& path, const MapData& map, uint tileSize = 256);
+
+	// Draws the floor of one tile into an all-wall tileSize x tileSize grid.
+	// Cell (0, 0) of the tile is map cell (tileX * tileSize, tileY * tileSize)
+	typedef std::function<void(uint tileX, uint tileY, Grid& tile)> TileFiller;
+
+	// Writes the file a tile at a time, for maps that can't be built in memory at all
+	bool SaveTiledMap(const std::string& path, uint width, uint height, uint tileSize, Position start, Position end,
+	                  const TileFiller& fill);
+
+	bool IsTiledMap(const std::string& path);
+
+	// Walkability of a tiled map file. A tile is read from disk the first time one of its cells is
+	// looked at and stays in memory until the memory limit needs room for another one, least recently used first.
+	// Read-only. Lookups change which tiles are in memory, so a map can't be shared between threads,
+	// open the file once per thread instead
+	class TiledMap {
+	public:
+		TiledMap() = default;
+		~TiledMap();
+
+		TiledMap(const TiledMap&) = delete;
+		TiledMap& operator=(const TiledMap&) = delete;
+
+		// memoryLimit is in bytes of tile data. At least a 3x3 block of tiles is kept whatever the limit
+		bool Open(const std::string& path, size_t memoryLimit);
+		void Close();
+		bool Empty() const { return tileCount == 0; }
+
+		uint Width() const { return size.width; }
+		uint Height() const { return size.height; }
+		uint TileSize() const { return 1u << tileShift; }
+		Position GetStart() const { return start; }
+		Position GetEnd() const { return end; }
+
+		bool InBounds(int x, int y) const {
+			return x >= 0 && y >= 0 && (uint)x < size.width && (uint)y < size.height;
+		}
+
+		// Cell must be in bounds
+		bool IsWalkable(uint x, uint y) const {
+			uint32_t tile = (x >> tileShift) + (y >> tileShift) * tileColumns;
+			if(tile != currentTile) Use(tile);
+			uint32_t bit = (x & tileMask) + ((y & tileMask) << tileShift);
+			return (currentBits[bit >> 6] >> (bit & 63)) & 1;
+		}
+
+		// Asks the OS to start reading a tile in the background, so it's quick to load when needed.
+		// Does nothing for tiles in memory or outside the map
+		void Prefetch(int tileX, int tileY) const;
+
+		size_t ResidentTiles() const { return slots.size(); }
+		size_t TileBytes() const { return tileWords * sizeof(uint64_t); }
+		uint64_t TileLoads() const { return loads; }
+		uint64_t TileEvictions() const { return evictions; }
+
+	private:
+		static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+		// A tile in memory, linked from most to least recently used
+		struct Slot {
+			uint32_t tile = NO_SLOT;
+			uint32_t newer = NO_SLOT;
+			uint32_t older = NO_SLOT;
+			std::vector<uint64_t> bits;
+		};
+
+		Size size = { 0, 0 };
+		uint tileShift = 0;
+		uint tileMask = 0;
+		uint tileColumns = 0;
+		uint tileRows = 0;
+		uint32_t tileCount = 0;
+		size_t tileWords = 0;
+		uint64_t tilesOffset = 0;
+		Position start = { UINT32_MAX, UINT32_MAX };
+		Position end = { UINT32_MAX, UINT32_MAX };
+		size_t maxSlots = 0;
+
+#ifdef __unix__
+		int file = -1;
+#else
+		mutable std::ifstream file;
+#endif
+
+		// Lookups are const, paging tiles in and out behind them is not
+		mutable std::vector<uint32_t> tileSlots; // Per tile, NO_SLOT when on disk only
+		mutable std::vector<Slot> slots;
+		mutable uint32_t newest = NO_SLOT;
+		mutable uint32_t oldest = NO_SLOT;
+		mutable uint32_t currentTile = NO_SLOT;
+		mutable const uint64_t* currentBits = nullptr;
+		mutable uint64_t loads = 0;
+		mutable uint64_t evictions = 0;
+
+		// Makes the tile current, reading it in if needed
+		void Use(uint32_t tile) const;
+		void Load(uint32_t tile, uint64_t* bits) const;
+		void Touch(uint32_t slot) const;
+		void Unlink(uint32_t slot) const;
+	};
+
+	inline bool IsOpen(const TiledMap& map, int x, int y) {
+		return map.InBounds(x, y) && map.IsWalkable(x, y);
+	}
+}
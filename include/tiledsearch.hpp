@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "policies.hpp"
+#include "search.hpp"
+#include "searchspace.hpp"
+#include "stats.hpp"
+#include "tiledmap.hpp"
+
+namespace Pathfinding {
+	// A* over a TiledMap. Cell data lives in a hash table of the cells reached so far instead of
+	// arrays over the whole map, so memory grows with the search, not with the map.
+	// Whenever expansion moves into another tile, the tiles next to it towards the end are prefetched.
+	// Tiled maps have no terrain, every policy runs on uniform cost
+	class TiledSearch {
+	public:
+		TiledSearch() = default;
+
+		void SetMap(const TiledMap* map);
+		void SetPolicy(SearchPolicy policy);
+		SearchPolicy GetPolicy() const { return policy; }
+
+		// Gives up without a path after reaching this many cells, 0 for no limit.
+		// Scratch memory is 16 to 64 bytes per reached cell, plus 16 per open set entry
+		void SetNodeLimit(size_t limit) { nodeLimit = limit; }
+
+		PathResult Solve(Position start, Position end);
+
+		const SearchStats& GetStats() const { return stats.Get(); }
+
+	private:
+		typedef PathResult (TiledSearch::*Kernel)(Position start, Position end);
+		static constexpr size_t KERNEL_COUNT = Policy::KERNEL_COUNT / 2; // Unweighted ones
+		static const std::array<Kernel, KERNEL_COUNT> KERNELS;
+
+		static constexpr uint64_t NO_KEY = UINT64_MAX;
+		static constexpr size_t INITIAL_NODES = 1 << 14;
+		static constexpr uint8_t NO_MOVE = UINT8_MAX;
+
+		// Open addressing, keys are y * width + x
+		struct Node {
+			uint64_t key = NO_KEY;
+			int gCost = 0;
+			uint8_t move = NO_MOVE; // Index of the move that reached the cell
+			NodeState state = Unvisited;
+		};
+
+		// Heap entries are never updated, a cheaper path pushes a new one and the old one is skipped
+		struct OpenEntry {
+			int fCost;
+			int hCost;
+			uint64_t key;
+		};
+
+		const TiledMap* map = nullptr;
+		SearchPolicy policy;
+		const Kernel* kernel = KERNELS.data();
+		size_t nodeLimit = 0;
+
+		std::vector<Node> nodes;
+		size_t nodeCount = 0;
+		std::vector<OpenEntry> open;
+		Stats stats;
+
+		template <class K> PathResult SolveWith(Position start, Position end);
+		// Slot of the cell, claimed for it if it wasn't reached yet. Claiming may move every other slot
+		Node& GetNode(uint64_t key);
+		void Grow();
+	};
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace Pathfinding {
+	// Memory that reads as all zero bits. Big blocks are fresh pages from the OS, which only
+	// commits them when first written, so per-cell scratch of a huge map costs memory for the
+	// cells a search reaches and nothing up front
+	void* AllocateZeroed(size_t bytes);
+	void FreeZeroed(void* memory, size_t bytes);
+
+	// Fixed-size array of plain values starting out as zero bits, used for per-cell search scratch
+	// where a zero means "not reached yet"
+	template <class T>
+	class ZeroedArray {
+		static_assert(std::is_trivially_copyable_v<T>);
+
+	public:
+		ZeroedArray() = default;
+		~ZeroedArray() { FreeZeroed(values, count * sizeof(T)); }
+
+		ZeroedArray(const ZeroedArray& other) { *this = other; }
+		ZeroedArray& operator=(const ZeroedArray& other) {
+			if(this != &other) {
+				Assign(other.count);
+				if(count != 0) memcpy(values, other.values, count * sizeof(T));
+			}
+			return *this;
+		}
+		ZeroedArray(ZeroedArray&& other) noexcept { *this = std::move(other); }
+		ZeroedArray& operator=(ZeroedArray&& other) noexcept {
+			std::swap(values, other.values);
+			std::swap(count, other.count);
+			return *this;
+		}
+
+		// Every value back to zero. Pages written before are handed back to the OS
+		void Assign(size_t _count) {
+			FreeZeroed(values, count * sizeof(T));
+			values = nullptr;
+			count = _count;
+			if(count != 0) values = (T*)AllocateZeroed(count * sizeof(T));
+		}
+
+		T& operator[](size_t index) { return values[index]; }
+		const T& operator[](size_t index) const { return values[index]; }
+		size_t size() const { return count; }
+
+	private:
+		T* values = nullptr;
+		size_t count = 0;
+	};
+}
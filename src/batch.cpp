@@ -0,0 +1,228 @@
+#include "batch.hpp"
+#include <algorithm>
+
+namespace Pathfinding {
+	namespace {
+		uint64_t PackRange(uint32_t begin, uint32_t end) {
+			return begin | ((uint64_t)end << 32);
+		}
+		uint32_t RangeBegin(uint64_t range) { return (uint32_t)range; }
+		uint32_t RangeEnd(uint64_t range) { return (uint32_t)(range >> 32); }
+	}
+
+	BatchSolver::BatchSolver(const Grid& _grid, uint threadCount) : grid(_grid) {
+		if(threadCount == 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		components.Build(grid);
+		cache.SetGrid(&grid);
+		for(uint i = 0; i < threadCount; i++) {
+			workers.push_back(std::make_unique<Worker>());
+			workers.back()->search.SetComponents(&components);
+		}
+		// Start threads only after the worker list is complete, thieves walk all of it
+		for(uint i = 0; i < threadCount; i++) {
+			workers[i]->thread = std::thread(&BatchSolver::WorkerLoop, this, i);
+		}
+	}
+
+	BatchSolver::~BatchSolver() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeWorkers.notify_all();
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->thread.join();
+		}
+	}
+
+	void BatchSolver::SetAlgorithm(Algorithm algorithm) {
+		if(algorithm == JumpPointSearchPlus && jumpTable.Empty()) {
+			jumpTable.Build(grid);
+		}
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->search.SetAlgorithm(algorithm, &jumpTable);
+		}
+	}
+
+	void BatchSolver::SetPolicy(SearchPolicy policy) {
+		bool diagonal = policy.connectivity == EightWay;
+		if(components.Diagonal() != diagonal) {
+			components.Build(grid, diagonal);
+		}
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->search.SetPolicy(policy);
+		}
+		cache.SetPolicy(policy);
+	}
+
+	void BatchSolver::SetCosts(const TerrainCosts* costs) {
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->search.SetCosts(costs);
+		}
+		cache.SetCosts(costs);
+	}
+
+	void BatchSolver::SetLandmarks(uint count) {
+		if(count > 0) landmarks.Build(grid, count, ThreadCount());
+		else landmarks = Landmarks();
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->search.SetLandmarks(&landmarks);
+		}
+	}
+
+	void BatchSolver::SetHierarchical(uint clusterSize) {
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->hierarchical.reset();
+		}
+		if(clusterSize == 0) {
+			clusterGraph = ClusterGraph();
+			return;
+		}
+
+		clusterGraph.Build(grid, clusterSize);
+		for(std::unique_ptr<Worker>& worker : workers) {
+			worker->hierarchical = std::make_unique<HierarchicalPathfinder>(clusterGraph);
+		}
+	}
+
+	std::vector<PathResult> BatchSolver::Solve(const std::vector<PathQuery>& _queries) {
+		std::vector<PathResult> _results(_queries.size());
+		if(_queries.empty()) {
+			return _results;
+		}
+		if(useFlowField) {
+			SolveWithFlowFields(_queries, _results);
+			return _results;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queries = &_queries;
+			results = &_results;
+
+			// Even initial split, stealing evens out the uneven query costs
+			uint32_t count = (uint32_t)_queries.size();
+			uint workerCount = (uint)workers.size();
+			for(uint i = 0; i < workerCount; i++) {
+				uint32_t begin = (uint32_t)((uint64_t)count * i / workerCount);
+				uint32_t end = (uint32_t)((uint64_t)count * (i + 1) / workerCount);
+				workers[i]->range.store(PackRange(begin, end));
+			}
+
+			busyWorkers = workerCount;
+			jobId++;
+			wakeWorkers.notify_all();
+			jobDone.wait(lock, [this] { return busyWorkers == 0; });
+
+			queries = nullptr;
+			results = nullptr;
+		}
+		return _results;
+	}
+
+	// Field builds use as many threads as the pool has, the pool itself sleeps meanwhile
+	void BatchSolver::SolveWithFlowFields(const std::vector<PathQuery>& _queries, std::vector<PathResult>& _results) {
+		std::vector<std::pair<CellIndex, uint32_t>> byEnd;
+		for(uint32_t i = 0; i < _queries.size(); i++) {
+			const PathQuery& q = _queries[i];
+			if(!grid.InBounds(q.start.x, q.start.y) || !grid.InBounds(q.end.x, q.end.y)) continue;
+			byEnd.push_back({ grid.Index(q.end.x, q.end.y), i });
+		}
+		std::sort(byEnd.begin(), byEnd.end());
+
+		for(const auto& [end, query] : byEnd) {
+			if(flowField.Empty() || flowField.GetGoal() != end) {
+				flowField.Build(grid, end, ThreadCount());
+			}
+			const PathQuery& q = _queries[query];
+			_results[query] = flowField.GetPath(grid.Index(q.start.x, q.start.y));
+		}
+		// The grid may change before the next Solve
+		flowField = FlowField();
+	}
+
+	void BatchSolver::WorkerLoop(uint index) {
+		Worker& worker = *workers[index];
+		uint64_t seenJob = 0;
+
+		while(true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeWorkers.wait(lock, [&] { return stopping || jobId != seenJob; });
+				if(stopping) return;
+				seenJob = jobId;
+			}
+
+			// Drain own range, then keep stealing until every range is empty
+			while(true) {
+				uint32_t query;
+				while(TakeOwn(worker, query)) {
+					const PathQuery& q = (*queries)[query];
+					if(!grid.InBounds(q.start.x, q.start.y) || !grid.InBounds(q.end.x, q.end.y)) continue;
+					CellIndex start = grid.Index(q.start.x, q.start.y);
+					CellIndex end = grid.Index(q.end.x, q.end.y);
+					// HPA* moves 8-way past corners whatever the policy
+					bool diagonalMoves = worker.hierarchical || worker.search.GetPolicy().connectivity == EightWay;
+					if(components.Separates(diagonalMoves) && !components.Connected(start, end)) continue;
+					if(worker.hierarchical) {
+						(*results)[query] = worker.hierarchical->Solve(start, end);
+						continue;
+					}
+					// Anytime paths aren't optimal, slices of them couldn't be trusted
+					PathResult& result = (*results)[query];
+					bool cached = worker.search.GetAlgorithm() != Anytime;
+					if(cached && cache.Lookup(start, end, result)) continue;
+					uint64_t version = cache.Version();
+					if(!worker.searchReady) {
+						worker.search.SetGrid(&grid);
+						worker.searchReady = true;
+					}
+					result = worker.search.Solve(start, end);
+					if(cached) cache.Store(start, end, version, result);
+				}
+				if(!Steal(index)) break;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+			if(busyWorkers == 0) {
+				jobDone.notify_one();
+			}
+		}
+	}
+
+	bool BatchSolver::TakeOwn(Worker& worker, uint32_t& query) {
+		uint64_t range = worker.range.load();
+		while(RangeBegin(range) < RangeEnd(range)) {
+			if(worker.range.compare_exchange_weak(range, PackRange(RangeBegin(range) + 1, RangeEnd(range)))) {
+				query = RangeBegin(range);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool BatchSolver::Steal(uint thief) {
+		uint workerCount = (uint)workers.size();
+		for(uint offset = 1; offset < workerCount; offset++) {
+			Worker& victim = *workers[(thief + offset) % workerCount];
+
+			uint64_t range = victim.range.load();
+			while(RangeBegin(range) < RangeEnd(range)) {
+				uint32_t begin = RangeBegin(range);
+				uint32_t end = RangeEnd(range);
+				// Take the back half, at least one query
+				uint32_t split = end - std::max(1u, (end - begin) / 2);
+				if(victim.range.compare_exchange_weak(range, PackRange(begin, split))) {
+					// Our own range is empty, nobody else can be writing to it
+					workers[thief]->range.store(PackRange(split, end));
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
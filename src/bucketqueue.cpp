@@ -0,0 +1,100 @@
+#include "bucketqueue.hpp"
+#include <algorithm>
+
+namespace Pathfinding {
+	void BucketQueue::Resize(size_t cellCount) {
+		buckets.assign(INITIAL_BUCKETS, {});
+		keys.Assign(cellCount);
+		count = 0;
+		entries = 0;
+	}
+
+	void BucketQueue::Push(CellIndex cell, int fCost, int) {
+		if(count == 0) {
+			// Outdated entries left from before could alias keys of the new window
+			if(entries != 0) Clear();
+			lowest = fCost;
+			highest = fCost;
+		}
+		count++;
+		SetKey(cell, fCost);
+		Insert(cell, fCost);
+	}
+
+	CellIndex BucketQueue::Pop() {
+		Advance();
+		std::vector<CellIndex>& bucket = Bucket(lowest);
+		CellIndex top = bucket.back();
+		bucket.pop_back();
+		entries--;
+		count--;
+		SetKey(top, NOT_QUEUED);
+		return top;
+	}
+
+	void BucketQueue::DecreaseKey(CellIndex cell, int fCost, int) {
+		SetKey(cell, fCost);
+		Insert(cell, fCost);
+	}
+
+	int BucketQueue::TopFCost() {
+		Advance();
+		return lowest;
+	}
+
+	void BucketQueue::Clear() {
+		if(entries != 0) {
+			for(std::vector<CellIndex>& bucket : buckets) {
+				for(CellIndex cell : bucket) {
+					SetKey(cell, NOT_QUEUED);
+				}
+				bucket.clear();
+			}
+		}
+		count = 0;
+		entries = 0;
+	}
+
+	void BucketQueue::Insert(CellIndex cell, int fCost) {
+		int newLowest = std::min(lowest, fCost);
+		int newHighest = std::max(highest, fCost);
+		size_t spread = (size_t)((int64_t)newHighest - newLowest);
+		if(spread >= buckets.size()) {
+			Grow(spread);
+		}
+		lowest = newLowest;
+		highest = newHighest;
+		Bucket(fCost).push_back(cell);
+		entries++;
+	}
+
+	void BucketQueue::Grow(size_t spread) {
+		size_t size = buckets.size();
+		while(size <= spread) size *= 2;
+
+		// Only current entries move over, each into the bucket of its key in the wider window
+		std::vector<std::vector<CellIndex>> old(size);
+		old.swap(buckets);
+		entries = 0;
+		size_t oldMask = old.size() - 1;
+		for(size_t index = 0; index < old.size(); index++) {
+			for(CellIndex cell : old[index]) {
+				if(Key(cell) == NOT_QUEUED || ((uint32_t)Key(cell) & oldMask) != index) continue;
+				Bucket(Key(cell)).push_back(cell);
+				entries++;
+			}
+		}
+	}
+
+	void BucketQueue::Advance() {
+		while(true) {
+			std::vector<CellIndex>& bucket = Bucket(lowest);
+			while(!bucket.empty() && Key(bucket.back()) != lowest) {
+				bucket.pop_back();
+				entries--;
+			}
+			if(!bucket.empty()) return;
+			lowest++;
+		}
+	}
+}
@@ -0,0 +1,216 @@
+#include "components.hpp"
+#include <cstdlib>
+
+namespace Pathfinding {
+	namespace {
+		// Whether two cells of the ring around a cell touch
+		bool Adjacent(Position a, Position b, bool diagonal) {
+			int dx = abs((int)a.x - (int)b.x);
+			int dy = abs((int)a.y - (int)b.y);
+			return diagonal ? dx <= 1 && dy <= 1 : dx + dy == 1;
+		}
+	}
+
+	void Components::Build(const Grid& grid, bool _diagonal) {
+		diagonal = _diagonal;
+		labels.assign(grid.CellCount(), NO_COMPONENT);
+		parent.clear();
+
+		// First pass: label from the neighbours already visited (west, north, and north-west and
+		// north-east with diagonals) and record which provisional labels meet
+		uint width = grid.Width();
+		for(uint y = 0; y < grid.Height(); y++) {
+			for(uint x = 0; x < width; x++) {
+				CellIndex cell = grid.Index(x, y);
+				if(!grid.IsWalkable(cell)) continue;
+
+				uint32_t label = NO_COMPONENT;
+				auto join = [&](CellIndex neighbour) {
+					uint32_t other = labels[neighbour];
+					if(other == NO_COMPONENT) return;
+					label = label == NO_COMPONENT ? other : Union(label, other);
+				};
+				if(x > 0) join(cell - 1);
+				if(y > 0) {
+					join(cell - width);
+					if(diagonal && x > 0) join(cell - width - 1);
+					if(diagonal && x + 1 < width) join(cell - width + 1);
+				}
+
+				if(label == NO_COMPONENT) {
+					label = (uint32_t)parent.size();
+					parent.push_back(label);
+				}
+				labels[cell] = label;
+			}
+		}
+
+		// Second pass: number the roots densely and point every cell straight at its root
+		std::vector<uint32_t> dense(parent.size(), NO_COMPONENT);
+		uint32_t count = 0;
+		for(uint32_t label = 0; label < parent.size(); label++) {
+			uint32_t root = Compress(label);
+			if(dense[root] == NO_COMPONENT) dense[root] = count++;
+			dense[label] = dense[root];
+		}
+		for(uint32_t& label : labels) {
+			if(label != NO_COMPONENT) label = dense[label];
+		}
+		parent.resize(count);
+		for(uint32_t label = 0; label < count; label++) {
+			parent[label] = label;
+		}
+	}
+
+	void Components::SetWalkable(const Grid& grid, CellIndex cell, bool walkable) {
+		if(labels.empty() || (labels[cell] != NO_COMPONENT) == walkable) return;
+
+		// All floor around the cell. Without diagonals only the sides are its neighbours,
+		// the corners can still link them
+		Position pos = grid.ToPosition(cell);
+		CellIndex ring[8];
+		bool neighbour[8];
+		int ringCount = 0;
+		for (int x = -1; x <= 1; x++) {
+			for (int y = -1; y <= 1; y++) {
+				if(x == 0 && y == 0) continue;
+				int checkX = (int)pos.x + x;
+				int checkY = (int)pos.y + y;
+				if(!grid.InBounds(checkX, checkY) || !grid.IsWalkable(grid.Index(checkX, checkY))) continue;
+				neighbour[ringCount] = diagonal || x == 0 || y == 0;
+				ring[ringCount++] = grid.Index(checkX, checkY);
+			}
+		}
+
+		if(walkable) {
+			uint32_t label = NO_COMPONENT;
+			for(int i = 0; i < ringCount; i++) {
+				if(!neighbour[i]) continue;
+				uint32_t other = Find(labels[ring[i]]);
+				label = label == NO_COMPONENT ? other : Union(label, other);
+			}
+			if(label == NO_COMPONENT) {
+				label = (uint32_t)parent.size();
+				parent.push_back(label);
+			}
+			labels[cell] = label;
+			return;
+		}
+
+		labels[cell] = NO_COMPONENT;
+
+		// Group the ring by adjacency. When every neighbour is in a single group
+		// they stay connected around the new wall, so nothing can have split
+		int group[8];
+		int groupCount = 0;
+		for(int i = 0; i < ringCount; i++) group[i] = -1;
+		for(int i = 0; i < ringCount; i++) {
+			if(group[i] >= 0) continue;
+			group[i] = groupCount;
+			// The ring is tiny, repeat until no more cells join
+			bool grown = true;
+			while(grown) {
+				grown = false;
+				for(int j = 0; j < ringCount; j++) {
+					if(group[j] != groupCount) continue;
+					Position a = grid.ToPosition(ring[j]);
+					for(int k = 0; k < ringCount; k++) {
+						if(group[k] >= 0) continue;
+						if(Adjacent(a, grid.ToPosition(ring[k]), diagonal)) {
+							group[k] = groupCount;
+							grown = true;
+						}
+					}
+				}
+			}
+			groupCount++;
+		}
+		int firstGroup = -1;
+		bool split = false;
+		for(int i = 0; i < ringCount; i++) {
+			if(!neighbour[i]) continue;
+			if(firstGroup < 0) firstGroup = group[i];
+			else if(group[i] != firstGroup) split = true;
+		}
+		if(!split) return;
+
+		// The groups may still meet further away. Flood all but the first with fresh labels,
+		// a group already reached by an earlier flood is connected to it
+		std::vector<uint32_t> flooded;
+		for(int g = 0; g < groupCount; g++) {
+			if(g == firstGroup) continue;
+			CellIndex seed = INVALID_CELL;
+			for(int i = 0; i < ringCount; i++) {
+				if(group[i] == g && neighbour[i]) {
+					seed = ring[i];
+					break;
+				}
+			}
+			// Corners that only touch the cell diagonally weren't connected through it
+			if(seed == INVALID_CELL) continue;
+
+			bool reached = false;
+			for(uint32_t label : flooded) {
+				if(labels[seed] == label) reached = true;
+			}
+			if(reached) continue;
+
+			uint32_t label = (uint32_t)parent.size();
+			parent.push_back(label);
+			Flood(grid, seed, label);
+			flooded.push_back(label);
+		}
+	}
+
+	uint32_t Components::Find(uint32_t label) const {
+		while(parent[label] != label) {
+			label = parent[label];
+		}
+		return label;
+	}
+
+	// Find that also halves the path on the way. Only used while writing,
+	// Find stays read-only so several threads can query at once
+	uint32_t Components::Compress(uint32_t label) {
+		while(parent[label] != label) {
+			parent[label] = parent[parent[label]];
+			label = parent[label];
+		}
+		return label;
+	}
+
+	uint32_t Components::Union(uint32_t labelA, uint32_t labelB) {
+		uint32_t rootA = Compress(labelA);
+		uint32_t rootB = Compress(labelB);
+		// The smaller label becomes the root, labels always point towards smaller ones
+		if(rootA < rootB) {
+			parent[rootB] = rootA;
+			return rootA;
+		}
+		parent[rootA] = rootB;
+		return rootB;
+	}
+
+	void Components::Flood(const Grid& grid, CellIndex seed, uint32_t label) {
+		queue.clear();
+		queue.push_back(seed);
+		labels[seed] = label;
+		for(size_t head = 0; head < queue.size(); head++) {
+			Position pos = grid.ToPosition(queue[head]);
+			for (int x = -1; x <= 1; x++) {
+				for (int y = -1; y <= 1; y++) {
+					if((x == 0 && y == 0) || (!diagonal && x != 0 && y != 0)) continue;
+					int checkX = (int)pos.x + x;
+					int checkY = (int)pos.y + y;
+					if(!grid.InBounds(checkX, checkY)) continue;
+
+					CellIndex neighbour = grid.Index(checkX, checkY);
+					if(!grid.IsWalkable(neighbour)) continue;
+					if(labels[neighbour] == label) continue;
+					labels[neighbour] = label;
+					queue.push_back(neighbour);
+				}
+			}
+		}
+	}
+}
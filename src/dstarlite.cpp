@@ -0,0 +1,270 @@
+#include "dstarlite.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace Pathfinding {
+	void DStarLite::SetGrid(Grid* _grid) {
+		grid = _grid;
+		gCost.assign(grid->CellCount(), INFINITE_COST);
+		rhs.assign(grid->CellCount(), INFINITE_COST);
+		queue.Resize(grid->CellCount());
+		startNode = INVALID_CELL;
+		endNode = INVALID_CELL;
+	}
+
+	void DStarLite::Begin(CellIndex start, CellIndex end) {
+		std::fill(gCost.begin(), gCost.end(), INFINITE_COST);
+		std::fill(rhs.begin(), rhs.end(), INFINITE_COST);
+		queue.Clear();
+
+		startNode = start;
+		lastStart = start;
+		endNode = end;
+		keyModifier = 0;
+		stats.Reset();
+		statsReported = false;
+
+		rhs[endNode] = 0;
+		int first, second;
+		CalculateKey(endNode, first, second);
+		queue.Push(endNode, first, second);
+		stats.Pushed(queue.Size());
+	}
+
+	void DStarLite::MoveStart(CellIndex start) {
+		if(start == startNode) return;
+		StartReplan();
+		startNode = start;
+
+		// Keys already in the queue were computed for the old start. Raising every new key
+		// by how far the start moved keeps them comparable without re-keying the queue
+		keyModifier += GetDistance(lastStart, startNode);
+		lastStart = startNode;
+	}
+
+	void DStarLite::SetWalkable(CellIndex cell, bool walkable) {
+		if(grid->IsWalkable(cell) == walkable) return;
+		StartReplan();
+		grid->SetWalkable(cell, walkable);
+
+		// Every edge touching the cell changed cost, so it and its neighbours need new lookaheads
+		CellIndex neighbours[9];
+		int neighbourCount = GetNeighbourNodes(cell, neighbours);
+		neighbours[neighbourCount++] = cell;
+		for(int i = 0; i < neighbourCount; i++) {
+			CellIndex neighbour = neighbours[i];
+			if(neighbour != endNode) {
+				rhs[neighbour] = BestNeighbourCost(neighbour);
+			}
+			UpdateVertex(neighbour);
+		}
+	}
+
+	CellIndex DStarLite::Step() {
+		if(UpToDate()) {
+			return INVALID_CELL;
+		}
+
+		CellIndex current = queue.Top();
+		int oldFirst = queue.TopFCost();
+		int oldSecond = queue.TopHCost();
+		int newFirst, newSecond;
+		CalculateKey(current, newFirst, newSecond);
+
+		CellIndex neighbours[9]; // Room for the cell itself
+		int neighbourCount = GetNeighbourNodes(current, neighbours);
+
+		if(KeyLess(oldFirst, oldSecond, newFirst, newSecond)) {
+			// Key is out of date since the start moved
+			queue.Update(current, newFirst, newSecond);
+			stats.Updated();
+			return current;
+		}
+
+		stats.Expanded();
+		if(gCost[current] > rhs[current]) {
+			// Overconsistent, cost went down. Settle it and let neighbours use it
+			gCost[current] = rhs[current];
+			queue.Remove(current);
+			stats.Popped();
+			for(int i = 0; i < neighbourCount; i++) {
+				CellIndex neighbour = neighbours[i];
+				stats.Generated();
+				if(neighbour != endNode) {
+					rhs[neighbour] = std::min(rhs[neighbour], EdgeCost(neighbour, current) + gCost[current]);
+				}
+				UpdateVertex(neighbour);
+			}
+		}
+		else {
+			// Underconsistent, cost went up. Everything that routed through it has to look again
+			int oldGCost = gCost[current];
+			gCost[current] = INFINITE_COST;
+			neighbours[neighbourCount++] = current;
+			for(int i = 0; i < neighbourCount; i++) {
+				CellIndex neighbour = neighbours[i];
+				stats.Generated();
+				if(neighbour != endNode && rhs[neighbour] == std::min(INFINITE_COST, EdgeCost(neighbour, current) + oldGCost)) {
+					rhs[neighbour] = BestNeighbourCost(neighbour);
+				}
+				UpdateVertex(neighbour);
+			}
+		}
+		return current;
+	}
+
+	bool DStarLite::Run() {
+		while(Step() != INVALID_CELL) {}
+		return rhs[startNode] < INFINITE_COST;
+	}
+
+	bool DStarLite::UpToDate() {
+		if(queue.Empty()) {
+			return true;
+		}
+		int startFirst, startSecond;
+		CalculateKey(startNode, startFirst, startSecond);
+		return !KeyLess(queue.TopFCost(), queue.TopHCost(), startFirst, startSecond) && rhs[startNode] <= gCost[startNode];
+	}
+
+	PathResult DStarLite::GetPath() {
+		PathResult result;
+		if(rhs[startNode] < INFINITE_COST) {
+			Stats::TimePoint phaseStart = stats.Now();
+			result.path = RetracePath(startNode);
+			stats.AddTime(&SearchStats::pathNs, phaseStart);
+
+			if(result.path.back() == grid->ToPosition(endNode)) {
+				result.found = true;
+				result.cost = rhs[startNode];
+			}
+			else {
+				result.path.clear();
+			}
+		}
+		result.stats = stats.Get();
+		statsReported = true;
+		return result;
+	}
+
+	std::vector<Position> DStarLite::RetracePath(CellIndex currentNode) {
+		std::vector<Position> path;
+		path.push_back(grid->ToPosition(currentNode));
+
+		// Bounded in case the values are mid-update and form a loop
+		while(currentNode != endNode && path.size() <= grid->CellCount()) {
+			CellIndex neighbours[8];
+			int neighbourCount = GetNeighbourNodes(currentNode, neighbours);
+
+			CellIndex best = INVALID_CELL;
+			int bestCost = INFINITE_COST;
+			for(int i = 0; i < neighbourCount; i++) {
+				int cost = EdgeCost(currentNode, neighbours[i]) + gCost[neighbours[i]];
+				if(cost < bestCost) {
+					bestCost = cost;
+					best = neighbours[i];
+				}
+			}
+			if(best == INVALID_CELL) break;
+
+			currentNode = best;
+			path.push_back(grid->ToPosition(currentNode));
+		}
+		return path;
+	}
+
+	void DStarLite::StartReplan() {
+		if(statsReported) {
+			stats.Reset();
+			statsReported = false;
+		}
+	}
+
+	NodeState DStarLite::GetState(CellIndex cell) const {
+		if(queue.Contains(cell)) return Open;
+		if(gCost[cell] < INFINITE_COST) return Closed;
+		return Unvisited;
+	}
+
+	void DStarLite::CalculateKey(CellIndex cell, int& first, int& second) {
+		second = std::min(gCost[cell], rhs[cell]);
+		first = second >= INFINITE_COST ? INFINITE_COST : second + GetDistance(startNode, cell) + keyModifier;
+	}
+
+	bool DStarLite::KeyLess(int firstA, int secondA, int firstB, int secondB) {
+		if(firstA != firstB) {
+			return firstA < firstB;
+		}
+		return secondA < secondB;
+	}
+
+	void DStarLite::UpdateVertex(CellIndex cell) {
+		bool inQueue = queue.Contains(cell);
+		if(gCost[cell] != rhs[cell]) {
+			int first, second;
+			CalculateKey(cell, first, second);
+			if(inQueue) {
+				queue.Update(cell, first, second);
+				stats.Updated();
+			}
+			else {
+				// Consistent cells with a finite cost were settled before
+				if(gCost[cell] < INFINITE_COST) stats.Reopened();
+				queue.Push(cell, first, second);
+				stats.Pushed(queue.Size());
+			}
+		}
+		else if(inQueue) {
+			queue.Remove(cell);
+			stats.Popped();
+		}
+	}
+
+	int DStarLite::BestNeighbourCost(CellIndex cell) {
+		CellIndex neighbours[8];
+		int neighbourCount = GetNeighbourNodes(cell, neighbours);
+
+		int best = INFINITE_COST;
+		for(int i = 0; i < neighbourCount; i++) {
+			best = std::min(best, EdgeCost(cell, neighbours[i]) + gCost[neighbours[i]]);
+		}
+		return std::min(best, INFINITE_COST);
+	}
+
+	int DStarLite::EdgeCost(CellIndex cellA, CellIndex cellB) {
+		if(!grid->IsWalkable(cellA) || !grid->IsWalkable(cellB)) {
+			return INFINITE_COST;
+		}
+		return GetDistance(cellA, cellB);
+	}
+
+	// All in-bounds neighbours, walls included. Walls are handled by EdgeCost
+	int DStarLite::GetNeighbourNodes(CellIndex cell, CellIndex* neighbours) {
+		int count = 0;
+		Position pos = grid->ToPosition(cell);
+		for (int x = -1; x <= 1; x++) {
+			for (int y = -1; y <= 1; y++) {
+				if(x == 0 && y == 0) continue; // skip self
+
+				int checkX = (int)pos.x + x;
+				int checkY = (int)pos.y + y;
+				if(!grid->InBounds(checkX, checkY)) continue;
+
+				neighbours[count++] = grid->Index(checkX, checkY);
+			}
+		}
+		return count;
+	}
+
+	int DStarLite::GetDistance(CellIndex cellA, CellIndex cellB) const {
+		Position posA = grid->ToPosition(cellA);
+		Position posB = grid->ToPosition(cellB);
+		int dstX = abs((int)posA.x - (int)posB.x);
+		int dstY = abs((int)posA.y - (int)posB.y);
+
+		if(dstX > dstY) {
+			return 14 * dstY + 10 * (dstX - dstY);
+		}
+		return 14 * dstX + 10 * (dstY - dstX);
+	}
+}
@@ -0,0 +1,183 @@
+#include "flowfield.hpp"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <thread>
+
+namespace Pathfinding {
+	namespace {
+		const int OFFSETS[8][2] = { { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+		// Below this many cells starting threads costs more than it saves
+		const size_t PARALLEL_CELLS = 1 << 16;
+		// A bucket this small is relaxed by one thread while the others wait
+		const size_t PARALLEL_FRONTIER = 256;
+
+		// Distance buckets are [10 * i, 10 * i + 10). A move adds 10 or 14,
+		// so only the current and the next two buckets are ever in use
+		const uint32_t BUCKET_WIDTH = 10;
+		const uint BUCKET_SLOTS = 3;
+
+		struct Entry {
+			CellIndex cell;
+			uint32_t distance; // Entries whose cell got cheaper since are skipped
+		};
+	}
+
+	void FlowField::Build(const Grid& _grid, CellIndex _goal, uint threadCount) {
+		grid = &_grid;
+		goal = _goal;
+		distance.assign(grid->CellCount(), UNREACHABLE);
+		direction.assign(grid->CellCount(), NO_DIRECTION);
+		if(goal == INVALID_CELL || !grid->IsWalkable(goal)) return;
+
+		if(threadCount == 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		if(grid->CellCount() < PARALLEL_CELLS) {
+			threadCount = 1;
+		}
+
+		// buckets[slot][thread], every thread only appends to its own lists
+		std::vector<std::vector<std::vector<Entry>>> buckets(BUCKET_SLOTS, std::vector<std::vector<Entry>>(threadCount));
+		distance[goal] = 0;
+		buckets[0][0].push_back(Entry{ goal, 0 });
+
+		uint32_t bucket = 0;
+		size_t frontierSize = 1;
+		bool done = false;
+
+		// Runs on one thread between rounds: moves on to the next bucket that has anything in it
+		auto nextRound = [&]() noexcept {
+			for(std::vector<Entry>& list : buckets[bucket % BUCKET_SLOTS]) {
+				list.clear();
+			}
+			for(uint skipped = 0; skipped < BUCKET_SLOTS; skipped++) {
+				bucket++;
+				frontierSize = 0;
+				for(const std::vector<Entry>& list : buckets[bucket % BUCKET_SLOTS]) {
+					frontierSize += list.size();
+				}
+				if(frontierSize > 0) return;
+			}
+			done = true;
+		};
+		std::barrier roundDone((std::ptrdiff_t)threadCount, nextRound);
+
+		auto relax = [&](uint thread, const Entry& entry) {
+			if(std::atomic_ref<uint32_t>(distance[entry.cell]).load(std::memory_order_relaxed) != entry.distance) return;
+
+			Position pos = grid->ToPosition(entry.cell);
+			for(int i = 0; i < 8; i++) {
+				int checkX = (int)pos.x + OFFSETS[i][0];
+				int checkY = (int)pos.y + OFFSETS[i][1];
+				if(!grid->InBounds(checkX, checkY)) continue;
+
+				CellIndex neighbour = grid->Index(checkX, checkY);
+				if(!grid->IsWalkable(neighbour)) continue;
+
+				uint32_t newDistance = entry.distance + (OFFSETS[i][0] != 0 && OFFSETS[i][1] != 0 ? 14 : 10);
+				std::atomic_ref<uint32_t> current(distance[neighbour]);
+				uint32_t old = current.load(std::memory_order_relaxed);
+				while(newDistance < old) {
+					if(current.compare_exchange_weak(old, newDistance, std::memory_order_relaxed)) {
+						buckets[(newDistance / BUCKET_WIDTH) % BUCKET_SLOTS][thread].push_back(Entry{ neighbour, newDistance });
+						break;
+					}
+				}
+			}
+		};
+
+		auto worker = [&](uint thread) {
+			while(!done) {
+				const std::vector<std::vector<Entry>>& lists = buckets[bucket % BUCKET_SLOTS];
+				if(frontierSize < PARALLEL_FRONTIER) {
+					if(thread == 0) {
+						for(const std::vector<Entry>& list : lists) {
+							for(const Entry& entry : list) relax(thread, entry);
+						}
+					}
+				}
+				else {
+					// Split the concatenated lists evenly
+					size_t first = frontierSize * thread / threadCount;
+					size_t last = frontierSize * (thread + 1) / threadCount;
+					size_t offset = 0;
+					for(const std::vector<Entry>& list : lists) {
+						size_t begin = std::max(first, offset);
+						size_t end = std::min(last, offset + list.size());
+						for(size_t i = begin; i < end; i++) relax(thread, list[i - offset]);
+						offset += list.size();
+						if(offset >= last) break;
+					}
+				}
+				roundDone.arrive_and_wait();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for(uint thread = 1; thread < threadCount; thread++) {
+			threads.emplace_back(worker, thread);
+		}
+		worker(0);
+		for(std::thread& thread : threads) {
+			thread.join();
+		}
+
+		// Distances are final, directions only read them. Rows are split between threads
+		threads.clear();
+		uint height = grid->Height();
+		for(uint thread = 1; thread < threadCount; thread++) {
+			threads.emplace_back(&FlowField::BuildDirections, this, height * thread / threadCount, height * (thread + 1) / threadCount);
+		}
+		BuildDirections(0, height / threadCount);
+		for(std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	// Points every reachable cell at the neighbour its distance came from. The first match wins,
+	// so the field doesn't depend on which thread relaxed what
+	void FlowField::BuildDirections(uint firstRow, uint endRow) {
+		for(uint y = firstRow; y < endRow; y++) {
+			for(uint x = 0; x < grid->Width(); x++) {
+				CellIndex cell = grid->Index(x, y);
+				if(cell == goal || distance[cell] == UNREACHABLE) continue;
+
+				for(int i = 0; i < 8; i++) {
+					int checkX = (int)x + OFFSETS[i][0];
+					int checkY = (int)y + OFFSETS[i][1];
+					if(!grid->InBounds(checkX, checkY)) continue;
+
+					CellIndex neighbour = grid->Index(checkX, checkY);
+					uint32_t cost = OFFSETS[i][0] != 0 && OFFSETS[i][1] != 0 ? 14 : 10;
+					if(distance[neighbour] != UNREACHABLE && distance[neighbour] + cost == distance[cell]) {
+						direction[cell] = (uint8_t)i;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	CellIndex FlowField::Next(CellIndex cell) const {
+		uint8_t next = direction[cell];
+		if(next == NO_DIRECTION) return INVALID_CELL;
+		Position pos = grid->ToPosition(cell);
+		return grid->Index(pos.x + OFFSETS[next][0], pos.y + OFFSETS[next][1]);
+	}
+
+	PathResult FlowField::GetPath(CellIndex start) const {
+		PathResult result;
+		if(Empty() || distance[start] == UNREACHABLE) {
+			return result;
+		}
+
+		result.found = true;
+		result.cost = (int)distance[start];
+		for(CellIndex cell = start; cell != INVALID_CELL; cell = Next(cell)) {
+			result.path.push_back(grid->ToPosition(cell));
+		}
+		return result;
+	}
+}
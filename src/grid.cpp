@@ -0,0 +1,74 @@
+#include "grid.hpp"
+#include <utility>
+
+namespace Pathfinding {
+	Grid::Grid(uint width, uint height) {
+		Resize(width, height);
+	}
+
+	Grid::Grid(const Grid& other) {
+		*this = other;
+	}
+
+	Grid::Grid(Grid&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	Grid& Grid::operator=(const Grid& other) {
+		if(this == &other) return *this;
+		size = other.size;
+		cellCount = other.cellCount;
+		storage.assign(other.bits, other.bits + other.WordCount());
+		bits = storage.data();
+		owner.reset();
+		version = std::max(version, other.version) + 1;
+		return *this;
+	}
+
+	Grid& Grid::operator=(Grid&& other) noexcept {
+		if(this == &other) return *this;
+		size = other.size;
+		cellCount = other.cellCount;
+		owner = std::move(other.owner);
+		storage = std::move(other.storage);
+		bits = owner ? other.bits : storage.data();
+		version = std::max(version, other.version) + 1;
+
+		other.size = { 0, 0 };
+		other.cellCount = 0;
+		other.bits = nullptr;
+		other.storage.clear();
+		return *this;
+	}
+
+	void Grid::Resize(uint width, uint height) {
+		size.width = width;
+		size.height = height;
+		cellCount = (size_t)width * height;
+		storage.assign(WordCount(), 0);
+		bits = storage.data();
+		owner.reset();
+		version++;
+	}
+
+	void Grid::Attach(uint width, uint height, uint64_t* _bits, std::shared_ptr<void> _owner) {
+		size.width = width;
+		size.height = height;
+		cellCount = (size_t)width * height;
+		storage.clear();
+		storage.shrink_to_fit();
+		bits = _bits;
+		owner = std::move(_owner);
+		version++;
+	}
+
+	Grid Grid::Transposed() const {
+		Grid transposed(size.height, size.width);
+		for(uint y = 0; y < size.height; y++) {
+			for(uint x = 0; x < size.width; x++) {
+				if(IsWalkable(Index(x, y))) transposed.SetWalkable(transposed.Index(y, x), true);
+			}
+		}
+		return transposed;
+	}
+}
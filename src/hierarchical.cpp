@@ -0,0 +1,523 @@
+#include "hierarchical.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+namespace Pathfinding {
+	namespace {
+		const uint32_t NO_PARENT = UINT32_MAX;
+
+		int OctileDistance(Position posA, Position posB) {
+			int dstX = abs((int)posA.x - (int)posB.x);
+			int dstY = abs((int)posA.y - (int)posB.y);
+
+			if(dstX > dstY) {
+				return 14 * dstY + 10 * (dstX - dstY);
+			}
+			return 14 * dstX + 10 * (dstY - dstX);
+		}
+	}
+
+	void ClusterSearch::Resize(uint size) {
+		size_t cellCount = (size_t)(size + 2) * (size + 2);
+		cost.assign(cellCount, 0);
+		parent.assign(cellCount, NO_PARENT);
+		stamp.assign(cellCount, 0);
+		targetStamp.assign(cellCount, 0);
+		walkable.assign(cellCount, 0);
+		queue.Resize(cellCount);
+		generation = 0;
+	}
+
+	void ClusterSearch::Run(const Grid& _grid, uint _x0, uint _y0, uint _x1, uint _y1, CellIndex source, CellIndex target) {
+		bool toTarget = target != INVALID_CELL;
+		Explore(_grid, _x0, _y0, _x1, _y1, source, &target, toTarget ? 1 : 0, toTarget);
+	}
+
+	void ClusterSearch::RunToAll(const Grid& _grid, uint _x0, uint _y0, uint _x1, uint _y1, CellIndex source,
+	                             const CellIndex* targets, size_t targetCount) {
+		Explore(_grid, _x0, _y0, _x1, _y1, source, targets, targetCount, false);
+	}
+
+	void ClusterSearch::Explore(const Grid& _grid, uint _x0, uint _y0, uint _x1, uint _y1, CellIndex source,
+	                            const CellIndex* targets, size_t targetCount, bool toTarget) {
+		grid = &_grid;
+		x0 = _x0;
+		y0 = _y0;
+		x1 = _x1;
+		y1 = _y1;
+		stride = x1 - x0 + 2;
+		uint height = y1 - y0;
+
+		generation++;
+		if(generation == 0) {
+			std::fill(stamp.begin(), stamp.end(), 0);
+			std::fill(targetStamp.begin(), targetStamp.end(), 0);
+			generation = 1;
+		}
+
+		for(uint y = 0; y < height + 2; y++) {
+			for(uint x = 0; x < stride; x++) {
+				bool inside = x > 0 && y > 0 && x + 1 < stride && y <= height;
+				walkable[x + y * stride] = inside && grid->IsWalkable(grid->Index(x0 + x - 1, y0 + y - 1));
+			}
+		}
+		for(size_t i = 0; i < targetCount; i++) {
+			targetStamp[Local(targets[i])] = generation;
+		}
+		size_t remaining = targetCount;
+
+		// With a single target this is A*, otherwise plain Dijkstra
+		uint32_t targetLocal = toTarget ? Local(targets[0]) : 0;
+		Position targetPos = { targetLocal % stride, targetLocal / stride };
+		auto heuristic = [&](uint32_t local) {
+			if(!toTarget) return 0;
+			return OctileDistance(Position{ local % stride, local / stride }, targetPos);
+		};
+
+		const int offsets[8] = { -(int)stride - 1, -(int)stride, -(int)stride + 1, -1, 1, (int)stride - 1, (int)stride, (int)stride + 1 };
+		const int moveCosts[8] = { 14, 10, 14, 10, 10, 14, 10, 14 };
+
+		queue.Clear();
+		uint32_t sourceLocal = Local(source);
+		stamp[sourceLocal] = generation;
+		cost[sourceLocal] = 0;
+		parent[sourceLocal] = NO_PARENT;
+		queue.Push(sourceLocal, heuristic(sourceLocal), 0);
+		stats.Pushed(queue.Size());
+
+		// The heuristic is consistent, expanded cells never get cheaper
+		while(!queue.Empty()) {
+			uint32_t current = queue.Pop();
+			stats.Popped();
+			stats.Expanded();
+			if(targetStamp[current] == generation && --remaining == 0) break;
+
+			for(int i = 0; i < 8; i++) {
+				uint32_t neighbour = current + offsets[i];
+				if(!walkable[neighbour]) continue;
+
+				stats.Generated();
+				int newCost = cost[current] + moveCosts[i];
+				if(stamp[neighbour] != generation) {
+					stamp[neighbour] = generation;
+					cost[neighbour] = newCost;
+					parent[neighbour] = current;
+					queue.Push(neighbour, newCost + heuristic(neighbour), 0);
+					stats.Pushed(queue.Size());
+				}
+				else if(newCost < cost[neighbour]) {
+					cost[neighbour] = newCost;
+					parent[neighbour] = current;
+					queue.DecreaseKey(neighbour, newCost + heuristic(neighbour), 0);
+					stats.Updated();
+				}
+			}
+		}
+	}
+
+	int ClusterSearch::GetCost(CellIndex cell) const {
+		if(!Contains(cell) || stamp[Local(cell)] != generation) {
+			return -1;
+		}
+		return cost[Local(cell)];
+	}
+
+	void ClusterSearch::AppendPath(CellIndex target, std::vector<Position>& path) const {
+		size_t first = path.size();
+		for(uint32_t local = Local(target); parent[local] != NO_PARENT; local = parent[local]) {
+			path.push_back(grid->ToPosition(Global(local)));
+		}
+		std::reverse(path.begin() + first, path.end());
+	}
+
+	bool ClusterSearch::Contains(CellIndex cell) const {
+		Position pos = grid->ToPosition(cell);
+		return pos.x >= x0 && pos.x < x1 && pos.y >= y0 && pos.y < y1;
+	}
+
+	uint32_t ClusterSearch::Local(CellIndex cell) const {
+		Position pos = grid->ToPosition(cell);
+		return (pos.x - x0 + 1) + (pos.y - y0 + 1) * stride;
+	}
+
+	CellIndex ClusterSearch::Global(uint32_t local) const {
+		return grid->Index(x0 + local % stride - 1, y0 + local / stride - 1);
+	}
+
+
+	void ClusterGraph::Build(const Grid& _grid, uint _clusterSize) {
+		grid = &_grid;
+		clusterSize = _clusterSize;
+		clustersX = (grid->Width() + clusterSize - 1) / clusterSize;
+		clustersY = (grid->Height() + clusterSize - 1) / clusterSize;
+
+		nodeCells.clear();
+		std::unordered_map<CellIndex, uint32_t> nodeOfCell;
+		auto addNode = [&](CellIndex cell) {
+			auto it = nodeOfCell.find(cell);
+			if(it != nodeOfCell.end()) return it->second;
+			uint32_t node = (uint32_t)nodeCells.size();
+			nodeCells.push_back(cell);
+			nodeOfCell[cell] = node;
+			return node;
+		};
+
+		struct RawEdge {
+			uint32_t from;
+			Edge edge;
+		};
+		std::vector<RawEdge> rawEdges;
+		auto addEntrance = [&](CellIndex a, CellIndex b) {
+			uint32_t nodeA = addNode(a);
+			uint32_t nodeB = addNode(b);
+			rawEdges.push_back(RawEdge{ nodeA, Edge{ nodeB, 10 } });
+			rawEdges.push_back(RawEdge{ nodeB, Edge{ nodeA, 10 } });
+		};
+
+		// Walks one border cell by cell. Every open stretch gets an entrance in the middle,
+		// or one at each end if it's long. Stretches are cut at cluster corners
+		auto scanBorder = [&](uint length, const std::function<bool(uint)>& isOpen, const std::function<void(uint)>& place) {
+			uint runStart = 0;
+			bool inRun = false;
+			for(uint i = 0; i <= length; i++) {
+				bool open = i < length && isOpen(i) && !(inRun && i % clusterSize == 0);
+				if(inRun && !open) {
+					uint runLength = i - runStart;
+					if(runLength < 6) {
+						place(runStart + runLength / 2);
+					}
+					else {
+						place(runStart);
+						place(i - 1);
+					}
+					inRun = false;
+				}
+				// A cut at a cluster corner immediately starts the next stretch
+				if(!inRun && i < length && isOpen(i)) {
+					runStart = i;
+					inRun = true;
+				}
+			}
+		};
+
+		for(uint cx = 1; cx < clustersX; cx++) {
+			uint x = cx * clusterSize;
+			scanBorder(grid->Height(),
+				[&](uint y) { return grid->IsWalkable(grid->Index(x - 1, y)) && grid->IsWalkable(grid->Index(x, y)); },
+				[&](uint y) { addEntrance(grid->Index(x - 1, y), grid->Index(x, y)); });
+		}
+		for(uint cy = 1; cy < clustersY; cy++) {
+			uint y = cy * clusterSize;
+			scanBorder(grid->Width(),
+				[&](uint x) { return grid->IsWalkable(grid->Index(x, y - 1)) && grid->IsWalkable(grid->Index(x, y)); },
+				[&](uint x) { addEntrance(grid->Index(x, y - 1), grid->Index(x, y)); });
+		}
+
+		// Group nodes by cluster
+		uint clusterCount = clustersX * clustersY;
+		clusterNodeStart.assign(clusterCount + 1, 0);
+		for(CellIndex cell : nodeCells) {
+			clusterNodeStart[ClusterOf(cell) + 1]++;
+		}
+		for(uint cluster = 0; cluster < clusterCount; cluster++) {
+			clusterNodeStart[cluster + 1] += clusterNodeStart[cluster];
+		}
+		clusterNodes.assign(nodeCells.size(), 0);
+		std::vector<uint32_t> fill(clusterNodeStart.begin(), clusterNodeStart.end() - 1);
+		for(uint32_t node = 0; node < nodeCells.size(); node++) {
+			clusterNodes[fill[ClusterOf(nodeCells[node])]++] = node;
+		}
+
+		// Link entrances inside each cluster with their exact path cost. Moves are symmetric, so each
+		// entrance only searches until the ones after it are settled and links both ways.
+		// Clusters are independent, so they're split between threads
+		uint threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), clusterCount));
+		std::vector<std::vector<RawEdge>> threadEdges(threadCount);
+		auto linkClusters = [&](uint thread) {
+			ClusterSearch clusterSearch;
+			clusterSearch.Resize(clusterSize);
+			std::vector<CellIndex> targets;
+			for(uint cluster = thread; cluster < clusterCount; cluster += threadCount) {
+				uint x0, y0, x1, y1;
+				ClusterBounds(cluster, x0, y0, x1, y1);
+				for(const uint32_t* from = ClusterNodesBegin(cluster); from + 1 < ClusterNodesEnd(cluster); from++) {
+					targets.clear();
+					for(const uint32_t* to = from + 1; to != ClusterNodesEnd(cluster); to++) {
+						targets.push_back(nodeCells[*to]);
+					}
+					clusterSearch.RunToAll(*grid, x0, y0, x1, y1, nodeCells[*from], targets.data(), targets.size());
+					for(const uint32_t* to = from + 1; to != ClusterNodesEnd(cluster); to++) {
+						int cost = clusterSearch.GetCost(nodeCells[*to]);
+						if(cost >= 0) {
+							threadEdges[thread].push_back(RawEdge{ *from, Edge{ *to, cost } });
+							threadEdges[thread].push_back(RawEdge{ *to, Edge{ *from, cost } });
+						}
+					}
+				}
+			}
+		};
+		std::vector<std::thread> threads;
+		for(uint thread = 1; thread < threadCount; thread++) {
+			threads.emplace_back(linkClusters, thread);
+		}
+		linkClusters(0);
+		for(std::thread& thread : threads) {
+			thread.join();
+		}
+		for(const std::vector<RawEdge>& edgesOfThread : threadEdges) {
+			rawEdges.insert(rawEdges.end(), edgesOfThread.begin(), edgesOfThread.end());
+		}
+
+		edgeStart.assign(nodeCells.size() + 1, 0);
+		for(const RawEdge& raw : rawEdges) {
+			edgeStart[raw.from + 1]++;
+		}
+		for(size_t node = 0; node < nodeCells.size(); node++) {
+			edgeStart[node + 1] += edgeStart[node];
+		}
+		edges.assign(rawEdges.size(), Edge{ 0, 0 });
+		fill.assign(edgeStart.begin(), edgeStart.end() - 1);
+		for(const RawEdge& raw : rawEdges) {
+			edges[fill[raw.from]++] = raw.edge;
+		}
+	}
+
+	uint ClusterGraph::ClusterOf(CellIndex cell) const {
+		Position pos = grid->ToPosition(cell);
+		return pos.x / clusterSize + (pos.y / clusterSize) * clustersX;
+	}
+
+	void ClusterGraph::ClusterBounds(uint cluster, uint& x0, uint& y0, uint& x1, uint& y1) const {
+		x0 = (cluster % clustersX) * clusterSize;
+		y0 = (cluster / clustersX) * clusterSize;
+		x1 = std::min(x0 + clusterSize, grid->Width());
+		y1 = std::min(y0 + clusterSize, grid->Height());
+	}
+
+
+	HierarchicalPathfinder::HierarchicalPathfinder(const ClusterGraph& _graph) : graph(_graph) {
+		startId = (uint32_t)graph.NodeCount();
+		endId = startId + 1;
+		space.Resize(graph.NodeCount() + 2);
+		clusterSearch.Resize(graph.ClusterSize());
+		localSearch.Resize(graph.ClusterSize() * 4);
+	}
+
+	PathResult HierarchicalPathfinder::Solve(CellIndex start, CellIndex end) {
+		PathResult result;
+		const Grid& grid = graph.GetGrid();
+		if(!grid.IsWalkable(start) || !grid.IsWalkable(end)) {
+			return result;
+		}
+		if(start == end) {
+			result.found = true;
+			result.path.push_back(grid.ToPosition(start));
+			return result;
+		}
+
+		stats.Reset();
+		clusterSearch.ResetStats();
+		localSearch.ResetStats();
+		Stats::TimePoint phaseStart = stats.Now();
+
+		// Temporary links from start and end to the entrances of their own clusters
+		uint endCluster = graph.ClusterOf(end);
+		startEdges.clear();
+		endEdges.clear();
+		Connect(start, end, startEdges);
+		Connect(end, INVALID_CELL, endEdges);
+		stats.AddTime(&SearchStats::setupNs, phaseStart);
+
+		// Ends in the same or touching clusters also get an exact search over the clusters around both.
+		// The abstract path crosses borders only at entrances, which can cost several times the
+		// direct way on trips this short
+		phaseStart = stats.Now();
+		int localCost = -1;
+		uint windowX0, windowY0, windowX1, windowY1;
+		if(LocalWindow(start, end, windowX0, windowY0, windowX1, windowY1)) {
+			localSearch.Run(grid, windowX0, windowY0, windowX1, windowY1, start, end);
+			localCost = localSearch.GetCost(end);
+		}
+		auto localResult = [&]() {
+			result.found = true;
+			result.cost = localCost;
+			result.path.push_back(grid.ToPosition(start));
+			localSearch.AppendPath(end, result.path);
+			result.stats = stats.Get();
+			result.stats += clusterSearch.GetStats();
+			result.stats += localSearch.GetStats();
+			return result;
+		};
+
+		// A* over the abstract graph
+		space.Reset();
+		space.gCost[startId] = 0;
+		space.parent[startId] = INVALID_CELL;
+		space.SetState(startId, Open);
+		int startHCost = Heuristic(start, end);
+		space.openSet.Push(startId, startHCost, startHCost);
+		stats.Pushed(space.openSet.Size());
+
+		bool found = false;
+		while(!space.openSet.Empty()) {
+			uint32_t current = space.openSet.Pop();
+			stats.Popped();
+			stats.Expanded();
+			space.SetState(current, Closed);
+			if(current == endId) {
+				found = true;
+				break;
+			}
+
+			auto relax = [&](uint32_t next, int edgeCost) {
+				stats.Generated();
+				NodeState state = space.GetState(next);
+				if(state == Closed) return;
+
+				bool isOpen = state == Open;
+				int newGCost = space.gCost[current] + edgeCost;
+				if(isOpen && newGCost >= space.gCost[next]) return;
+
+				space.gCost[next] = newGCost;
+				int hCost = Heuristic(Cell(next, start, end), end);
+				space.parent[next] = current;
+				if(!isOpen) {
+					space.SetState(next, Open);
+					space.openSet.Push(next, newGCost + hCost, hCost);
+					stats.Pushed(space.openSet.Size());
+				}
+				else {
+					space.openSet.DecreaseKey(next, newGCost + hCost, hCost);
+					stats.Updated();
+				}
+			};
+
+			if(current == startId) {
+				for(const ClusterGraph::Edge& edge : startEdges) {
+					relax(edge.to, edge.cost);
+				}
+				continue;
+			}
+			for(const ClusterGraph::Edge* edge = graph.EdgesBegin(current); edge != graph.EdgesEnd(current); edge++) {
+				relax(edge->to, edge->cost);
+			}
+			if(graph.ClusterOf(graph.NodeCell(current)) == endCluster) {
+				for(const ClusterGraph::Edge& edge : endEdges) {
+					if(edge.to == current) relax(endId, edge.cost);
+				}
+			}
+		}
+
+		stats.AddTime(&SearchStats::searchNs, phaseStart);
+
+		// The abstract path is kept only when it's cheaper
+		if(localCost >= 0 && (!found || localCost <= space.gCost[endId])) {
+			return localResult();
+		}
+		if(!found) {
+			// Lazily allocated, most maps never need it
+			if(!fallbackReady) {
+				fallback.SetGrid(&grid);
+				fallbackReady = true;
+			}
+			result = fallback.Solve(start, end);
+			result.stats += stats.Get();
+			result.stats += clusterSearch.GetStats();
+			result.stats += localSearch.GetStats();
+			return result;
+		}
+
+		// Refine the corridor: in-cluster steps get a local search, border crossings are single moves
+		std::vector<uint32_t> nodes;
+		for(uint32_t node = endId; node != INVALID_CELL; node = space.parent[node]) {
+			nodes.push_back(node);
+		}
+		std::reverse(nodes.begin(), nodes.end());
+
+		phaseStart = stats.Now();
+		result.found = true;
+		result.cost = space.gCost[endId];
+		result.path.push_back(grid.ToPosition(start));
+		for(size_t i = 1; i < nodes.size(); i++) {
+			CellIndex from = Cell(nodes[i - 1], start, end);
+			CellIndex to = Cell(nodes[i], start, end);
+			if(from == to) continue;
+
+			uint cluster = graph.ClusterOf(from);
+			if(cluster == graph.ClusterOf(to)) {
+				uint x0, y0, x1, y1;
+				graph.ClusterBounds(cluster, x0, y0, x1, y1);
+				clusterSearch.Run(grid, x0, y0, x1, y1, from, to);
+				clusterSearch.AppendPath(to, result.path);
+			}
+			else {
+				result.path.push_back(grid.ToPosition(to));
+			}
+		}
+		stats.AddTime(&SearchStats::pathNs, phaseStart);
+
+		result.stats = stats.Get();
+		result.stats += clusterSearch.GetStats();
+		result.stats += localSearch.GetStats();
+		return result;
+	}
+
+	void HierarchicalPathfinder::Connect(CellIndex cell, CellIndex end, std::vector<ClusterGraph::Edge>& links) {
+		uint cluster = graph.ClusterOf(cell);
+		uint x0, y0, x1, y1;
+		graph.ClusterBounds(cluster, x0, y0, x1, y1);
+		targets.clear();
+		for(const uint32_t* node = graph.ClusterNodesBegin(cluster); node != graph.ClusterNodesEnd(cluster); node++) {
+			targets.push_back(graph.NodeCell(*node));
+		}
+		bool endInCluster = end != INVALID_CELL && graph.ClusterOf(end) == cluster;
+		if(endInCluster) {
+			targets.push_back(end);
+		}
+		clusterSearch.RunToAll(graph.GetGrid(), x0, y0, x1, y1, cell, targets.data(), targets.size());
+
+		for(const uint32_t* node = graph.ClusterNodesBegin(cluster); node != graph.ClusterNodesEnd(cluster); node++) {
+			int cost = clusterSearch.GetCost(graph.NodeCell(*node));
+			if(cost >= 0) {
+				links.push_back(ClusterGraph::Edge{ *node, cost });
+			}
+		}
+		if(endInCluster && clusterSearch.GetCost(end) >= 0) {
+			links.push_back(ClusterGraph::Edge{ endId, clusterSearch.GetCost(end) });
+		}
+	}
+
+	bool HierarchicalPathfinder::LocalWindow(CellIndex start, CellIndex end, uint& x0, uint& y0, uint& x1, uint& y1) const {
+		const Grid& grid = graph.GetGrid();
+		uint size = graph.ClusterSize();
+		Position startCluster = grid.ToPosition(start);
+		Position endCluster = grid.ToPosition(end);
+		startCluster = Position{ startCluster.x / size, startCluster.y / size };
+		endCluster = Position{ endCluster.x / size, endCluster.y / size };
+		if(abs((int)startCluster.x - (int)endCluster.x) > 1 || abs((int)startCluster.y - (int)endCluster.y) > 1) {
+			return false;
+		}
+
+		// Both clusters and one more around them
+		x0 = (std::max(std::min(startCluster.x, endCluster.x), 1u) - 1) * size;
+		y0 = (std::max(std::min(startCluster.y, endCluster.y), 1u) - 1) * size;
+		x1 = std::min((std::max(startCluster.x, endCluster.x) + 2) * size, grid.Width());
+		y1 = std::min((std::max(startCluster.y, endCluster.y) + 2) * size, grid.Height());
+		return true;
+	}
+
+	// Inflated by 5%. The abstract graph is approximate anyway and an exact heuristic
+	// leaves huge plateaus of equal cost on open maps
+	int HierarchicalPathfinder::Heuristic(CellIndex cell, CellIndex end) const {
+		return OctileDistance(graph.GetGrid().ToPosition(cell), graph.GetGrid().ToPosition(end)) * 21 / 20;
+	}
+
+	CellIndex HierarchicalPathfinder::Cell(uint32_t node, CellIndex start, CellIndex end) const {
+		if(node == startId) return start;
+		if(node == endId) return end;
+		return graph.NodeCell(node);
+	}
+}
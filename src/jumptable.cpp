@@ -0,0 +1,90 @@
+#include "jumptable.hpp"
+#include <utility>
+
+namespace Pathfinding {
+	JumpTable::JumpTable(const JumpTable& other) {
+		*this = other;
+	}
+
+	JumpTable::JumpTable(JumpTable&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	JumpTable& JumpTable::operator=(const JumpTable& other) {
+		if(this == &other) return *this;
+		storage.assign(other.distances, other.distances + other.count);
+		distances = storage.data();
+		count = other.count;
+		owner.reset();
+		return *this;
+	}
+
+	JumpTable& JumpTable::operator=(JumpTable&& other) noexcept {
+		if(this == &other) return *this;
+		owner = std::move(other.owner);
+		storage = std::move(other.storage);
+		distances = owner ? other.distances : storage.data();
+		count = other.count;
+
+		other.distances = nullptr;
+		other.count = 0;
+		other.storage.clear();
+		return *this;
+	}
+
+	void JumpTable::Attach(const int16_t* _distances, size_t _count, std::shared_ptr<void> _owner) {
+		storage.clear();
+		storage.shrink_to_fit();
+		distances = _distances;
+		count = _count;
+		owner = std::move(_owner);
+	}
+
+	void JumpTable::Build(const Grid& grid) {
+		storage.assign(grid.CellCount() * 4, 0);
+		distances = storage.data();
+		count = storage.size();
+		owner.reset();
+		std::vector<int> scratch;
+
+		for(uint y = 0; y < grid.Height(); y++) {
+			BuildLine(grid, 0, y, 1, 0, grid.Width(), scratch);
+			BuildLine(grid, grid.Width() - 1, y, -1, 0, grid.Width(), scratch);
+		}
+		for(uint x = 0; x < grid.Width(); x++) {
+			BuildLine(grid, x, 0, 0, 1, grid.Height(), scratch);
+			BuildLine(grid, x, grid.Height() - 1, 0, -1, grid.Height(), scratch);
+		}
+	}
+
+	// Fills one row or column for direction (dx, dy), starting from the cell it points away from.
+	// Walks backwards from the far end so every cell reuses the answer of the cell in front of it
+	void JumpTable::BuildLine(const Grid& grid, uint x, uint y, int dx, int dy, uint length, std::vector<int>& scratch) {
+		Direction direction = ToDirection(dx, dy);
+		scratch.assign(length, 0);
+
+		for(int i = (int)length - 1; i >= 0; i--) {
+			int cellX = (int)x + dx * i;
+			int cellY = (int)y + dy * i;
+			if(!IsOpen(grid, cellX, cellY)) continue;
+
+			int nextX = cellX + dx;
+			int nextY = cellY + dy;
+			int distance;
+			if(!IsOpen(grid, nextX, nextY)) {
+				distance = 0;
+			}
+			else if(IsStraightJumpPoint(grid, nextX, nextY, dx, dy)) {
+				distance = 1;
+			}
+			else {
+				int next = scratch[i + 1];
+				distance = next > 0 ? next + 1 : next - 1;
+			}
+			scratch[i] = distance;
+
+			CellIndex cell = grid.Index(cellX, cellY);
+			storage[(size_t)cell * 4 + direction] = (distance > FAR_STEPS || distance < -FAR_STEPS) ? FAR : (int16_t)distance;
+		}
+	}
+}
@@ -0,0 +1,162 @@
+#include "landmarks.hpp"
+#include "flowfield.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <thread>
+
+namespace Pathfinding {
+	void Landmarks::Build(const Grid& grid, uint count, uint threadCount) {
+		landmarks.clear();
+		distances.clear();
+		scales.clear();
+		exact = true;
+		if(grid.CellCount() == 0 || count == 0) return;
+
+		// Evenly spaced along the border, clockwise from the top left corner
+		uint width = grid.Width();
+		uint height = grid.Height();
+		uint perimeter = 2 * (width - 1) + 2 * (height - 1);
+		for(uint i = 0; i < count; i++) {
+			uint along = perimeter == 0 ? 0 : (uint)((uint64_t)perimeter * i / count);
+			uint x, y;
+			if(along < width - 1) { x = along; y = 0; }
+			else if((along -= width - 1) < height - 1) { x = width - 1; y = along; }
+			else if((along -= height - 1) < width - 1) { x = width - 1 - along; y = height - 1; }
+			else { x = 0; y = height - 1 - (along - (width - 1)); }
+
+			CellIndex landmark = NearestFloor(grid, x, y);
+			if(landmark != INVALID_CELL && std::find(landmarks.begin(), landmarks.end(), landmark) == landmarks.end()) {
+				landmarks.push_back(landmark);
+			}
+		}
+		if(landmarks.empty()) return;
+
+		if(threadCount == 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		threadCount = std::min(threadCount, (uint)landmarks.size());
+
+		// One table per landmark first, interleaved per cell afterwards
+		size_t landmarkCount = landmarks.size();
+		std::vector<std::vector<uint16_t>> tables(landmarkCount);
+		scales.assign(landmarkCount, 1);
+		auto buildTables = [&](uint thread) {
+			FlowField field;
+			for(size_t i = thread; i < landmarkCount; i += threadCount) {
+				field.Build(grid, landmarks[i], 1);
+
+				uint32_t longest = 0;
+				for(CellIndex cell = 0; cell < grid.CellCount(); cell++) {
+					uint32_t cost = field.GetDistance(cell);
+					if(cost != FlowField::UNREACHABLE) longest = std::max(longest, cost);
+				}
+				// Largest stored value has to stay below UNREACHABLE
+				uint scale = std::max(1u, (uint)((longest + (uint64_t)UNREACHABLE - 2) / (UNREACHABLE - 1)));
+				scales[i] = scale;
+
+				tables[i].resize(grid.CellCount());
+				for(CellIndex cell = 0; cell < grid.CellCount(); cell++) {
+					uint32_t cost = field.GetDistance(cell);
+					tables[i][cell] = cost == FlowField::UNREACHABLE ? UNREACHABLE : (uint16_t)(cost / scale);
+				}
+			}
+		};
+		std::vector<std::thread> threads;
+		for(uint thread = 1; thread < threadCount; thread++) {
+			threads.emplace_back(buildTables, thread);
+		}
+		buildTables(0);
+		for(std::thread& thread : threads) {
+			thread.join();
+		}
+
+		for(uint scale : scales) {
+			if(scale > 1) exact = false;
+		}
+		distances.resize(grid.CellCount() * landmarkCount);
+		for(size_t i = 0; i < landmarkCount; i++) {
+			for(CellIndex cell = 0; cell < grid.CellCount(); cell++) {
+				distances[(size_t)cell * landmarkCount + i] = tables[i][cell];
+			}
+			std::vector<uint16_t>().swap(tables[i]);
+		}
+	}
+
+	bool Landmarks::Open(const Grid& grid, CellIndex cell) {
+		if(landmarks.empty()) return true;
+		// Rounded costs can't be lowered exactly
+		if(!exact) return false;
+
+		// The same moves the flow fields the tables come from make
+		size_t landmarkCount = landmarks.size();
+		typedef std::pair<uint32_t, CellIndex> Entry;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> frontier;
+		auto relax = [&](size_t i, CellIndex from, uint32_t cost, auto&& visit) {
+			Position pos = grid.ToPosition(from);
+			for(int dy = -1; dy <= 1; dy++) {
+				for(int dx = -1; dx <= 1; dx++) {
+					int checkX = (int)pos.x + dx;
+					int checkY = (int)pos.y + dy;
+					if((dx == 0 && dy == 0) || !grid.InBounds(checkX, checkY)) continue;
+					CellIndex neighbour = grid.Index(checkX, checkY);
+					if(!grid.IsWalkable(neighbour)) continue;
+					if(!visit(neighbour, cost + (dx != 0 && dy != 0 ? 14 : 10), distances[(size_t)neighbour * landmarkCount + i])) {
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+
+		for(size_t i = 0; i < landmarkCount; i++) {
+			// The opened cell's cost through its cheapest neighbour
+			uint32_t best = UINT32_MAX;
+			relax(i, cell, 0, [&](CellIndex, uint32_t step, uint16_t stored) {
+				if(stored != UNREACHABLE) best = std::min(best, stored + step);
+				return true;
+			});
+			// Walled off from this landmark
+			if(best == UINT32_MAX) continue;
+			if(best >= UNREACHABLE) return false;
+			distances[(size_t)cell * landmarkCount + i] = (uint16_t)best;
+			frontier.push(Entry(best, cell));
+
+			// Only cells whose cost went down are queued
+			while(!frontier.empty()) {
+				Entry entry = frontier.top();
+				frontier.pop();
+				if(distances[(size_t)entry.second * landmarkCount + i] != entry.first) continue;
+				bool fits = relax(i, entry.second, entry.first, [&](CellIndex neighbour, uint32_t cost, uint16_t& stored) {
+					if(stored != UNREACHABLE && cost >= stored) return true;
+					if(cost >= UNREACHABLE) return false;
+					stored = (uint16_t)cost;
+					frontier.push(Entry(cost, neighbour));
+					return true;
+				});
+				if(!fits) return false;
+			}
+		}
+		return true;
+	}
+
+	// Closest walkable cell by Chebyshev distance, searched in growing rings
+	CellIndex Landmarks::NearestFloor(const Grid& grid, uint x, uint y) const {
+		uint maxRadius = std::max(grid.Width(), grid.Height());
+		for(uint radius = 0; radius < maxRadius; radius++) {
+			int r = (int)radius;
+			for(int dy = -r; dy <= r; dy++) {
+				for(int dx = -r; dx <= r; dx++) {
+					if(std::max(abs(dx), abs(dy)) != r) continue;
+					int checkX = (int)x + dx;
+					int checkY = (int)y + dy;
+					if(grid.InBounds(checkX, checkY) && grid.IsWalkable(grid.Index(checkX, checkY))) {
+						return grid.Index(checkX, checkY);
+					}
+				}
+			}
+		}
+		return INVALID_CELL;
+	}
+}
@@ -1,50 +1,64 @@
 #include <drawpp.hpp>
 #include "pathfinding.hpp"
+#include <chrono>
 #include <iostream>
+#include <string>
 
 // Global variables
 DImage map;
-DImage result;
+DImage result; // Map with the path drawn on it, kept between frames
+std::vector<Pathfinding::Position> drawnPath;
+bool pathStale = true;  // Map pixels under the path changed
+bool resultDirty = true; // Needs uploading to the GPU
 
 Pathfinding::Pathfinder pathfinder;
-std::vector<Pathfinding::Node*> pathdata;
 Color pathColor = Color(0, 0, 0, 255);
 
+// Relative to the working directory, assets are copied next to the executable
+std::string mapPath = "assets/input.bmp";
+std::string fontPath = "assets/tuffy.ttf";
+Pathfinding::TerrainPalette palette;
+
 int imageScale = 6;
 
+// Search time per frame, the rest of a 60 fps frame is left for drawing
+Pathfinding::StepBudget frameBudget{ 0, std::chrono::milliseconds(8) };
+
 float timer = 0;
+bool landmarks = false;
 float winTime = 0;
 
 // Setup is called once before the application loop starts
 void setup() {
 	// Map is original image, for clearing drawn path every frame
-	map = loadImage("/home/trapie/projects/pathfinding/build/bin/assets/input.bmp");
+	map = loadImage(mapPath);
 	result = createImage(map.pixels(), map.width(), map.height());
 
-	// Create Node objects out of pixels
-	for (int i = 0; i < result.width() * result.height(); i++) {
-		uint x = i % result.width();
-		uint y = i / result.width(); // Float to uint -> floored automatically
-		pathdata.push_back( new Pathfinding::Node(x, y, &result[i]) );
-	}
-	// Send node data to pathfinder object
-	pathfinder.SetData(pathdata);
-	pathfinder.SetMapSize( map.width(), map.height() );
+	// Send pixel data to pathfinder object
+	pathfinder.SetData( Pathfinding::ClassifyPixels(map.pixels(), map.width(), map.height(), &palette) );
 
 	// Resize window to fit two maps
 	size(map.width()*imageScale, map.height()*imageScale);
 
 	// Load font from assets folder and set to render black
-    	textFont(loadFont("/home/trapie/projects/pathfinding/build/bin/assets/tuffy.ttf", 30) );
+    	textFont(loadFont(fontPath, 30) );
 	fill(0,0,0);
 }
 
+// Changes the map and the shown image without redrawing the whole image
+void SetMapPixel(Pathfinding::Position pos, Color color) {
+	size_t index = pos.x + pos.y * map.width();
+	map[index] = color;
+	result[index] = color;
+	pathStale = true;
+	resultDirty = true;
+}
+
 
 // Draw is called once every frame
 void draw(float deltaTime) {
-	// Do one A* step. DoStep does nothing if path is complete
-	// TODO If in the future there's more algorithms, they could be selected with SetAlgorithm() and this would do step for selected one
-	Pathfinding::Node* currentNode = pathfinder.DoStep();
+	// Search for up to the frame budget. Step does nothing if path is complete
+	Pathfinding::Position currentNode = pathfinder.Step(frameBudget);
 	if (!pathfinder.pathFound) {
 		timer += deltaTime;
 	}
@@ -52,37 +66,44 @@ void draw(float deltaTime) {
 		winTime = timer;
 	}
 
-	// Clear previous frame path
-	result = createImage(map.pixels(), map.width(), map.height());
-
-	// TODO DEBUG Tested nodes heatmap
-	// for(Pathfinding::Node* node : pathdata) {
-	// 	result[node->pos.x + node->pos.y * map.width()].blue -= node->tested * 10;
-	// 	result[node->pos.x + node->pos.y * map.width()].green -= node->tested * 10;
+	// TODO DEBUG Open and closed set colours
+	// for (int i = 0; i < map.width() * map.height(); i++) {
+	// 	Pathfinding::NodeState state = pathfinder.GetNodeState(i % map.width(), i / map.width());
+	// 	if(state == Pathfinding::Open) result[i] = Color(70, 70, 255);
+	// 	if(state == Pathfinding::Closed) result[i] = Color(100, 100, 200);
 	// }
 
-	// TODO DEBUG Open and closed set colours (need to move sets to public in pathfinding.hpp)
-	// for(Pathfinding::Node* node : pathfinder.openSet) {
-	// 	result[node->pos.x + node->pos.y * map.width()] = Color(70, 70, 255);
-	// }
-	// for(Pathfinding::Node* node : pathfinder.closedSet) {
-	// 	result[node->pos.x + node->pos.y * map.width()] = Color(100, 100, 200);
-	// }
-
-	// Print path
-	std::vector<Pathfinding::Node*> path = pathfinder.RetracePath(currentNode);
-	for(Pathfinding::Node* node : path) {
-		result[node->pos.x + node->pos.y * map.width()] = pathColor;
+	// Only the cells of the old and new path change
+	std::vector<Pathfinding::Position> path = pathfinder.RetracePath(currentNode);
+	if(pathStale || path != drawnPath) {
+		for(Pathfinding::Position pos : drawnPath) {
+			result[pos.x + pos.y * map.width()] = map[pos.x + pos.y * map.width()];
+		}
+		for(Pathfinding::Position pos : path) {
+			result[pos.x + pos.y * map.width()] = pathColor;
+		}
+		drawnPath.swap(path);
+		pathStale = false;
+		resultDirty = true;
 	}
 
-	// apply new pixels to texture for GPU
-	result.apply();
+	// apply new pixels to texture for GPU, only on frames where they changed
+	if(resultDirty) {
+		result.apply();
+		resultDirty = false;
+	}
 
 	// Render image
 	image( result, 0, 0, result.width()*imageScale, result.height()*imageScale );
 
 	// Render timer
 	text("Time: " + std::to_string(timer), map.width()*imageScale - 250, 30);
+	if (pathfinder.noPath) {
+		text("No path", map.width()*imageScale - 250, 110);
+	}
+#if PATHFINDING_STATS
+	text("Expanded: " + std::to_string(pathfinder.GetStats().nodesExpanded), map.width()*imageScale - 250, 70);
+#endif
 
 }
 
@@ -91,71 +112,129 @@ void draw(float deltaTime) {
 void keyPressed() {
 	Pathfinding::Position origStart = pathfinder.GetStartNodePosition();
 	Pathfinding::Position origEnd = pathfinder.GetEndNodePosition();
-	Pathfinding::Node* newNode;
+	Pathfinding::Position newNode;
 	timer = 0;
 
 	switch (key) {
 		case VK_ESC:
 			exit();
 		break;
+		// Number keys select the algorithm
+		case VK_1:
+			pathfinder.SetAlgorithm(Pathfinding::AStar);
+		break;
+		case VK_2:
+			pathfinder.SetAlgorithm(Pathfinding::JumpPointSearch);
+		break;
+		case VK_3:
+			pathfinder.SetAlgorithm(Pathfinding::JumpPointSearchPlus);
+		break;
+		case VK_4:
+			pathfinder.SetAlgorithm(Pathfinding::Incremental);
+		break;
+		case VK_5:
+			pathfinder.SetAlgorithm(Pathfinding::Bidirectional);
+		break;
+		case VK_6:
+			pathfinder.SetAlgorithm(Pathfinding::Anytime);
+		break;
+		// H toggles the landmark heuristic
+		case VK_H:
+			landmarks = !landmarks;
+			pathfinder.SetLandmarks(landmarks ? 8 : 0);
+		break;
+		// M cycles through 8-way, 8-way without corner cutting and 4-way moves
+		case VK_M: {
+			Pathfinding::SearchPolicy policy = pathfinder.GetPolicy();
+			policy.connectivity = (Pathfinding::Connectivity)((policy.connectivity + 1) % 3);
+			policy.metric = policy.connectivity == Pathfinding::FourWay ? Pathfinding::Manhattan : Pathfinding::Octile;
+			pathfinder.SetPolicy(policy);
+		}
+		break;
 		// WASD moves start node
 		case VK_W:
-			map[origStart.x + origStart.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origStart, Color(255, 255, 255));
 			newNode = pathfinder.MoveStart(origStart.x, origStart.y - 1);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(0, 0, 255);
+			SetMapPixel(newNode, Color(0, 0, 255));
 		break;
 		case VK_A:
-			map[origStart.x + origStart.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origStart, Color(255, 255, 255));
 			newNode = pathfinder.MoveStart(origStart.x - 1, origStart.y);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(0, 0, 255);
+			SetMapPixel(newNode, Color(0, 0, 255));
 		break;
 		case VK_S:
-			map[origStart.x + origStart.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origStart, Color(255, 255, 255));
 			newNode = pathfinder.MoveStart(origStart.x, origStart.y + 1);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(0, 0, 255);
+			SetMapPixel(newNode, Color(0, 0, 255));
 		break;
 		case VK_D:
-			map[origStart.x + origStart.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origStart, Color(255, 255, 255));
 			newNode = pathfinder.MoveStart(origStart.x + 1, origStart.y);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(0, 0, 255);
+			SetMapPixel(newNode, Color(0, 0, 255));
 		break;
 		// IJKL moves end node
 		case VK_I:
-			map[origEnd.x + origEnd.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origEnd, Color(255, 255, 255));
 			newNode = pathfinder.MoveEnd(origEnd.x, origEnd.y - 1);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(255, 0, 0);
+			SetMapPixel(newNode, Color(255, 0, 0));
 		break;
 		case VK_J:
-			map[origEnd.x + origEnd.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origEnd, Color(255, 255, 255));
 			newNode = pathfinder.MoveEnd(origEnd.x - 1, origEnd.y);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(255, 0, 0);
+			SetMapPixel(newNode, Color(255, 0, 0));
 		break;
 		case VK_K:
-			map[origEnd.x + origEnd.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origEnd, Color(255, 255, 255));
 			newNode = pathfinder.MoveEnd(origEnd.x, origEnd.y + 1);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(255, 0, 0);
+			SetMapPixel(newNode, Color(255, 0, 0));
 		break;
 		case VK_L:
-			map[origEnd.x + origEnd.y * map.width()] = Color(255, 255, 255);
+			SetMapPixel(origEnd, Color(255, 255, 255));
 			newNode = pathfinder.MoveEnd(origEnd.x + 1, origEnd.y);
 			pathfinder.ResetPath();
-			map[newNode->pos.x + newNode->pos.y * map.width()] = Color(255, 0, 0);
+			SetMapPixel(newNode, Color(255, 0, 0));
 		break;
 	}
 }
 
 
-int main() {
+// Clicking toggles a cell between wall and floor
+void mouseClicked() {
+	uint x = mouseX / imageScale;
+	uint y = mouseY / imageScale;
+	if(x >= (uint)map.width() || y >= (uint)map.height()) return;
+
+	Pathfinding::Position start = pathfinder.GetStartNodePosition();
+	Pathfinding::Position end = pathfinder.GetEndNodePosition();
+	if((x == start.x && y == start.y) || (x == end.x && y == end.y)) return;
+
+	bool makeWall = pathfinder.GetGrid().IsWalkable(x, y);
+	pathfinder.SetWalkable(x, y, !makeWall);
+	SetMapPixel(Pathfinding::Position{ x, y }, makeWall ? Color(0, 255, 0) : Color(255, 255, 255));
+	timer = 0;
+}
+
+
+int main(int argc, char** argv) {
+	// Optional map path as the first argument and terrain palette as the second
+	if(argc > 1) {
+		mapPath = argv[1];
+	}
+	if(argc > 2 && !Pathfinding::LoadPalette(argv[2], palette)) {
+		return 1;
+	}
+
 	// Create the application object
 	Application app(1000, 1000, "Pathfinding");
 	app.setKeyPressed(keyPressed);
+	app.setMouseClicked(mouseClicked);
 
 	// Run the application
 	return app.run(draw,setup);
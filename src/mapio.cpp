@@ -0,0 +1,227 @@
+#include "mapio.hpp"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Pathfinding {
+	namespace {
+		struct Rgb {
+			uint8_t red;
+			uint8_t green;
+			uint8_t blue;
+		};
+
+		uint32_t ReadU32(const uint8_t* data) {
+			return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+		}
+
+		uint16_t ReadU16(const uint8_t* data) {
+			return data[0] | (data[1] << 8);
+		}
+
+		const char COMPACT_MAGIC[8] = { 'P', 'F', 'M', 'A', 'P', 0, 0, 0 };
+		constexpr uint32_t COMPACT_VERSION = 1;
+
+		struct CompactHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t start;
+			uint32_t end;
+			uint32_t flags; // None defined yet
+			uint64_t bitsOffset;
+			uint64_t jumpTableOffset;
+			uint8_t reserved[16];
+		};
+		static_assert(sizeof(CompactHeader) == 64, "Compact map header must stay 64 bytes");
+
+		// Whole file in memory, either mapped or read. Freed with the last grid using it
+		std::shared_ptr<void> MapFile(const std::string& path, size_t& fileSize) {
+#ifdef __unix__
+			int fd = open(path.c_str(), O_RDONLY);
+			if(fd < 0) return nullptr;
+			struct stat info;
+			if(fstat(fd, &info) != 0 || info.st_size == 0) {
+				close(fd);
+				return nullptr;
+			}
+			fileSize = (size_t)info.st_size;
+			// Private and writable: edits copy the touched page instead of writing to the file
+			void* address = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if(address == MAP_FAILED) return nullptr;
+			return std::shared_ptr<void>(address, [fileSize](void* mapped) { munmap(mapped, fileSize); });
+#else
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if(!file) return nullptr;
+			fileSize = (size_t)file.tellg();
+			file.seekg(0);
+			// uint64_t storage keeps the bits aligned
+			auto buffer = std::make_shared<std::vector<uint64_t>>((fileSize + 7) / 8);
+			if(!file.read((char*)buffer->data(), fileSize)) return nullptr;
+			return std::shared_ptr<void>(buffer, buffer->data());
+#endif
+		}
+	}
+
+	bool LoadBitmap(const std::string& path, MapData& map, const TerrainPalette* palette) {
+		std::ifstream file(path, std::ios::binary);
+		if(!file) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			return false;
+		}
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		// File header (14 bytes) + at least BITMAPINFOHEADER (40 bytes)
+		if(data.size() < 54 || data[0] != 'B' || data[1] != 'M') {
+			printf("ERROR: %s is not a bitmap\n", path.c_str());
+			return false;
+		}
+
+		uint32_t pixelOffset = ReadU32(&data[10]);
+		int32_t width = (int32_t)ReadU32(&data[18]);
+		int32_t height = (int32_t)ReadU32(&data[22]);
+		uint16_t bitsPerPixel = ReadU16(&data[28]);
+		uint32_t compression = ReadU32(&data[30]);
+
+		// 3 = BI_BITFIELDS, used by 32 bit files with the default BGRA masks
+		if((bitsPerPixel != 24 && bitsPerPixel != 32) || (compression != 0 && compression != 3) || width <= 0 || height == 0) {
+			printf("ERROR: %s: only uncompressed 24 and 32 bit bitmaps are supported\n", path.c_str());
+			return false;
+		}
+
+		// Rows are stored bottom-up unless height is negative, each padded to 4 bytes
+		bool bottomUp = height > 0;
+		uint absHeight = (uint)(bottomUp ? height : -height);
+		uint bytesPerPixel = bitsPerPixel / 8;
+		size_t rowSize = ((size_t)width * bytesPerPixel + 3) & ~(size_t)3;
+		if(pixelOffset + rowSize * absHeight > data.size()) {
+			printf("ERROR: %s is truncated\n", path.c_str());
+			return false;
+		}
+
+		std::vector<Rgb> pixels((size_t)width * absHeight);
+		for(uint y = 0; y < absHeight; y++) {
+			const uint8_t* row = &data[pixelOffset + rowSize * (bottomUp ? absHeight - 1 - y : y)];
+			for(uint x = 0; x < (uint)width; x++) {
+				const uint8_t* px = row + x * bytesPerPixel;
+				pixels[x + y * (size_t)width] = Rgb{ px[2], px[1], px[0] };
+			}
+		}
+
+		map = ClassifyPixels(pixels.data(), (uint)width, absHeight, palette);
+		return true;
+	}
+
+	bool SaveCompactMap(const std::string& path, const MapData& map, const JumpTable* jumpTable) {
+		if(std::endian::native != std::endian::little) {
+			printf("ERROR: Compact maps are only supported on little-endian machines\n");
+			return false;
+		}
+		const Grid& grid = map.grid;
+
+		CompactHeader header = {};
+		memcpy(header.magic, COMPACT_MAGIC, sizeof(header.magic));
+		header.version = COMPACT_VERSION;
+		header.width = grid.Width();
+		header.height = grid.Height();
+		header.start = map.start;
+		header.end = map.end;
+		header.bitsOffset = sizeof(CompactHeader);
+		size_t bitsSize = grid.WordCount() * sizeof(uint64_t);
+		bool storeTable = jumpTable != nullptr && jumpTable->Size() == grid.CellCount() * 4;
+		header.jumpTableOffset = storeTable ? header.bitsOffset + bitsSize : 0;
+
+		std::ofstream file(path, std::ios::binary);
+		if(!file) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			return false;
+		}
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)grid.Bits(), bitsSize);
+		if(storeTable) {
+			file.write((const char*)jumpTable->Data(), jumpTable->Size() * sizeof(int16_t));
+		}
+		if(!file) {
+			printf("ERROR: Could not write %s\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool LoadCompactMap(const std::string& path, MapData& map) {
+		if(std::endian::native != std::endian::little) {
+			printf("ERROR: Compact maps are only supported on little-endian machines\n");
+			return false;
+		}
+
+		size_t fileSize = 0;
+		std::shared_ptr<void> file = MapFile(path, fileSize);
+		if(!file) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			return false;
+		}
+
+		uint8_t* data = (uint8_t*)file.get();
+		CompactHeader header;
+		if(fileSize < sizeof(header)) {
+			printf("ERROR: %s is not a compact map\n", path.c_str());
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+		if(memcmp(header.magic, COMPACT_MAGIC, sizeof(header.magic)) != 0) {
+			printf("ERROR: %s is not a compact map\n", path.c_str());
+			return false;
+		}
+		if(header.version != COMPACT_VERSION) {
+			printf("ERROR: %s: unsupported compact map version %u\n", path.c_str(), header.version);
+			return false;
+		}
+
+		size_t cellCount = (size_t)header.width * header.height;
+		size_t bitsSize = (cellCount + 63) / 64 * sizeof(uint64_t);
+		size_t tableSize = cellCount * 4 * sizeof(int16_t);
+		bool valid = header.width > 0 && header.height > 0 && cellCount <= INVALID_CELL
+			&& header.bitsOffset % sizeof(uint64_t) == 0 && header.bitsOffset >= sizeof(header)
+			&& header.bitsOffset <= fileSize && bitsSize <= fileSize - header.bitsOffset
+			&& (header.start == INVALID_CELL || header.start < cellCount)
+			&& (header.end == INVALID_CELL || header.end < cellCount);
+		if(valid && header.jumpTableOffset != 0) {
+			valid = header.jumpTableOffset % sizeof(int16_t) == 0 && header.jumpTableOffset <= fileSize
+				&& tableSize <= fileSize - header.jumpTableOffset;
+		}
+		if(!valid) {
+			printf("ERROR: %s is truncated or corrupt\n", path.c_str());
+			return false;
+		}
+
+		map.grid.Attach(header.width, header.height, (uint64_t*)(data + header.bitsOffset), file);
+		map.start = header.start;
+		map.end = header.end;
+
+		map.jumpTable = JumpTable();
+		if(header.jumpTableOffset != 0) {
+			map.jumpTable.Attach((const int16_t*)(data + header.jumpTableOffset), cellCount * 4, file);
+		}
+		return true;
+	}
+
+	bool LoadMap(const std::string& path, MapData& map, const TerrainPalette* palette) {
+		char magic[sizeof(COMPACT_MAGIC)] = {};
+		std::ifstream file(path, std::ios::binary);
+		file.read(magic, sizeof(magic));
+		if(memcmp(magic, COMPACT_MAGIC, sizeof(magic)) == 0) {
+			return LoadCompactMap(path, map);
+		}
+		return LoadBitmap(path, map, palette);
+	}
+}
@@ -0,0 +1,98 @@
+#include "openset.hpp"
+
+namespace Pathfinding {
+	void OpenSet::Resize(size_t cellCount) {
+		heap.clear();
+		slots.Assign(cellCount);
+	}
+
+	void OpenSet::Push(CellIndex cell, int fCost, int hCost) {
+		heap.push_back(Entry{ fCost, hCost, cell });
+		SiftUp(heap.size() - 1);
+	}
+
+	CellIndex OpenSet::Pop() {
+		CellIndex top = heap.front().cell;
+		Entry last = heap.back();
+		heap.pop_back();
+
+		if(!heap.empty()) {
+			Place(last, 0);
+			SiftDown(0);
+		}
+		slots[top] = NOT_IN_HEAP;
+		return top;
+	}
+
+	CellIndex OpenSet::Top() {
+		return heap.front().cell;
+	}
+
+	void OpenSet::DecreaseKey(CellIndex cell, int fCost, int hCost) {
+		size_t index = slots[cell] - 1;
+		heap[index].fCost = fCost;
+		heap[index].hCost = hCost;
+		SiftUp(index);
+	}
+
+	void OpenSet::Update(CellIndex cell, int fCost, int hCost) {
+		size_t index = slots[cell] - 1;
+		heap[index].fCost = fCost;
+		heap[index].hCost = hCost;
+		SiftUp(index);
+		SiftDown(slots[cell] - 1);
+	}
+
+	void OpenSet::Remove(CellIndex cell) {
+		size_t index = slots[cell] - 1;
+		Entry last = heap.back();
+		heap.pop_back();
+		slots[cell] = NOT_IN_HEAP;
+
+		// Move the last entry into the hole and let it find its place
+		if(index < heap.size()) {
+			Place(last, index);
+			SiftUp(index);
+			SiftDown(slots[last.cell] - 1);
+		}
+	}
+
+	void OpenSet::Clear() {
+		for(const Entry& entry : heap) {
+			slots[entry.cell] = NOT_IN_HEAP;
+		}
+		heap.clear();
+	}
+
+	void OpenSet::Place(const Entry& entry, size_t index) {
+		heap[index] = entry;
+		slots[entry.cell] = (uint32_t)index + 1;
+	}
+
+	void OpenSet::SiftUp(size_t index) {
+		Entry entry = heap[index];
+		while(index > 0) {
+			size_t parent = (index - 1) / 2;
+			if(!Less(entry, heap[parent])) break;
+			Place(heap[parent], index);
+			index = parent;
+		}
+		Place(entry, index);
+	}
+
+	void OpenSet::SiftDown(size_t index) {
+		Entry entry = heap[index];
+		size_t size = heap.size();
+		while(true) {
+			size_t child = index * 2 + 1;
+			if(child >= size) break;
+			if(child + 1 < size && Less(heap[child + 1], heap[child])) {
+				child++;
+			}
+			if(!Less(heap[child], entry)) break;
+			Place(heap[child], index);
+			index = child;
+		}
+		Place(entry, index);
+	}
+}
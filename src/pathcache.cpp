@@ -0,0 +1,292 @@
+#include "pathcache.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace Pathfinding {
+	namespace {
+		typedef Policy::Moves<EightWay> Directions;
+
+		constexpr uint32_t MAX_RUN = 32;
+
+		// Index of the step in Directions::MOVES, or -1 if the cells aren't neighbours
+		int DirectionOf(Position from, Position to) {
+			int dx = (int)to.x - (int)from.x;
+			int dy = (int)to.y - (int)from.y;
+			if(dx < -1 || dx > 1 || dy < -1 || dy > 1 || (dx == 0 && dy == 0)) return -1;
+			int direction = (dx + 1) * 3 + dy + 1;
+			return direction < 4 ? direction : direction - 1;
+		}
+	}
+
+	PathCache::PathCache(size_t _capacity) : capacity(_capacity) {}
+
+	void PathCache::SetGrid(const Grid* _grid) {
+		std::lock_guard<std::mutex> lock(mutex);
+		grid = _grid;
+		ClearLocked();
+	}
+
+	void PathCache::SetCapacity(size_t _capacity) {
+		std::lock_guard<std::mutex> lock(mutex);
+		capacity = std::min<size_t>(_capacity, NO_SLOT);
+		ClearLocked();
+	}
+
+	void PathCache::SetPolicy(SearchPolicy _policy) {
+		std::lock_guard<std::mutex> lock(mutex);
+		policy = _policy;
+		ClearLocked();
+	}
+
+	void PathCache::SetCosts(const TerrainCosts* _costs) {
+		std::lock_guard<std::mutex> lock(mutex);
+		costs = _costs != nullptr && !_costs->Empty() ? _costs : nullptr;
+		ClearLocked();
+	}
+
+	void PathCache::Clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		ClearLocked();
+	}
+
+	void PathCache::ClearLocked() {
+		entries.clear();
+		freeSlots.clear();
+		cells.clear();
+		startPositions.clear();
+		newest = NO_SLOT;
+		oldest = NO_SLOT;
+		// Searches started before the clear may have used the old settings
+		version++;
+	}
+
+	bool PathCache::Lookup(CellIndex start, CellIndex end, PathResult& result) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if(capacity == 0) return false;
+
+		uint32_t slot, first, last;
+		if(!Find(start, end, slot, first, last)) {
+			misses++;
+			return false;
+		}
+		hits++;
+		Touch(slot);
+
+		result = PathResult();
+		result.found = true;
+		result.path.reserve(last - first + 1);
+		ForEachCell(entries[slot], [&](CellIndex cell, uint32_t position, Policy::Move move) {
+			if(position < first || position > last) return;
+			result.path.push_back(grid->ToPosition(cell));
+			if(position == first) return;
+			int moveCost = move.dx != 0 && move.dy != 0 && policy.cost == OctileCost ? 14 : 10;
+			result.cost += costs != nullptr ? moveCost * costs->Get(cell) : moveCost;
+		});
+		return true;
+	}
+
+	void PathCache::Store(CellIndex start, CellIndex end, uint64_t _version, const PathResult& result) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if(capacity == 0 || _version != version || !result.found || result.path.size() < 2) return;
+
+		// Already covered, maybe by a longer path
+		uint32_t slot, first, last;
+		if(Find(start, end, slot, first, last)) {
+			Touch(slot);
+			return;
+		}
+
+		std::vector<uint8_t> runs;
+		for(size_t i = 1; i < result.path.size(); i++) {
+			int direction = DirectionOf(result.path[i - 1], result.path[i]);
+			if(direction < 0) return;
+			if(!runs.empty() && (runs.back() & 7) == direction && (runs.back() >> 3) + 1u < MAX_RUN) {
+				runs.back() += 8;
+			}
+			else {
+				runs.push_back((uint8_t)direction);
+			}
+		}
+
+		if(freeSlots.empty()) {
+			if(entries.size() < capacity) {
+				freeSlots.push_back((uint32_t)entries.size());
+				entries.emplace_back();
+				startPositions.push_back(NO_SLOT);
+			}
+			else {
+				Remove(oldest);
+			}
+		}
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+
+		Entry& entry = entries[slot];
+		entry.start = start;
+		entry.end = end;
+		entry.cost = result.cost;
+		entry.cellCount = (uint32_t)result.path.size();
+		entry.runs = std::move(runs);
+		Touch(slot);
+		for(uint32_t position = 0; position < entry.cellCount; position++) {
+			const Position& pos = result.path[position];
+			cells[grid->Index(pos.x, pos.y)].push_back(PathRef{ slot, position });
+		}
+	}
+
+	void PathCache::SetWalkable(CellIndex cell, bool walkable) {
+		std::lock_guard<std::mutex> lock(mutex);
+		version++;
+		if(entries.empty()) return;
+
+		std::vector<uint32_t> stale;
+		if(!walkable) {
+			auto collect = [&](CellIndex blocked) {
+				auto it = cells.find(blocked);
+				if(it == cells.end()) return;
+				for(const PathRef& ref : it->second) stale.push_back(ref.slot);
+			};
+			collect(cell);
+			// Diagonal moves past the new wall's sides are gone too
+			if(policy.connectivity == EightWayNoCorners) {
+				Position pos = grid->ToPosition(cell);
+				if(pos.x > 0) collect(cell - 1);
+				if(pos.x + 1 < grid->Width()) collect(cell + 1);
+				if(pos.y > 0) collect(cell - grid->Width());
+				if(pos.y + 1 < grid->Height()) collect(cell + grid->Width());
+				std::sort(stale.begin(), stale.end());
+				stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+			}
+		}
+		else {
+			// Without corner cutting the new cell also opens diagonals between its neighbours without
+			// entering it, those paths can be up to two straight moves minus a diagonal cheaper
+			int slack = 0;
+			if(policy.connectivity == EightWayNoCorners) {
+				slack = (policy.cost == OctileCost ? 6 : 10) * (costs != nullptr ? std::max<int>(costs->MinCost(), 1) : 1);
+			}
+			for(uint32_t slot = newest; slot != NO_SLOT; slot = entries[slot].older) {
+				const Entry& entry = entries[slot];
+				if(LowerBound(entry.start, cell) + LowerBound(cell, entry.end) - slack < entry.cost) {
+					stale.push_back(slot);
+				}
+			}
+		}
+
+		for(uint32_t slot : stale) {
+			Remove(slot);
+		}
+	}
+
+	uint64_t PathCache::Version() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return version;
+	}
+
+	size_t PathCache::Size() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size() - freeSlots.size();
+	}
+
+	uint64_t PathCache::Hits() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return hits;
+	}
+
+	uint64_t PathCache::Misses() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return misses;
+	}
+
+	bool PathCache::Find(CellIndex start, CellIndex end, uint32_t& slot, uint32_t& first, uint32_t& last) {
+		if(start == end) return false;
+		auto starts = cells.find(start);
+		auto ends = cells.find(end);
+		if(starts == cells.end() || ends == cells.end()) return false;
+
+		// Paths through the start, then the first one that reaches the end after it
+		for(const PathRef& ref : starts->second) {
+			startPositions[ref.slot] = ref.position;
+		}
+		bool found = false;
+		for(const PathRef& ref : ends->second) {
+			if(startPositions[ref.slot] < ref.position) {
+				slot = ref.slot;
+				first = startPositions[ref.slot];
+				last = ref.position;
+				found = true;
+				break;
+			}
+		}
+		for(const PathRef& ref : starts->second) {
+			startPositions[ref.slot] = NO_SLOT;
+		}
+		return found;
+	}
+
+	void PathCache::Touch(uint32_t slot) {
+		Unlink(slot);
+		Entry& entry = entries[slot];
+		entry.older = newest;
+		if(newest != NO_SLOT) entries[newest].newer = slot;
+		newest = slot;
+		if(oldest == NO_SLOT) oldest = slot;
+	}
+
+	void PathCache::Unlink(uint32_t slot) {
+		Entry& entry = entries[slot];
+		if(entry.newer != NO_SLOT) entries[entry.newer].older = entry.older;
+		else if(newest == slot) newest = entry.older;
+		if(entry.older != NO_SLOT) entries[entry.older].newer = entry.newer;
+		else if(oldest == slot) oldest = entry.newer;
+		entry.newer = NO_SLOT;
+		entry.older = NO_SLOT;
+	}
+
+	void PathCache::Remove(uint32_t slot) {
+		Entry& entry = entries[slot];
+		ForEachCell(entry, [&](CellIndex cell, uint32_t, Policy::Move) {
+			auto it = cells.find(cell);
+			std::vector<PathRef>& refs = it->second;
+			for(size_t i = 0; i < refs.size(); i++) {
+				if(refs[i].slot != slot) continue;
+				refs[i] = refs.back();
+				refs.pop_back();
+				break;
+			}
+			if(refs.empty()) cells.erase(it);
+		});
+		Unlink(slot);
+		entry.start = INVALID_CELL;
+		entry.end = INVALID_CELL;
+		entry.runs.clear();
+		freeSlots.push_back(slot);
+	}
+
+	template <class Visit>
+	void PathCache::ForEachCell(const Entry& entry, Visit&& visit) const {
+		Position pos = grid->ToPosition(entry.start);
+		uint32_t position = 0;
+		visit(entry.start, position, Policy::Move{ 0, 0 });
+		for(uint8_t run : entry.runs) {
+			Policy::Move move = Directions::MOVES[run & 7];
+			for(uint32_t step = 0; step <= (uint32_t)(run >> 3); step++) {
+				pos.x += move.dx;
+				pos.y += move.dy;
+				visit(grid->Index(pos.x, pos.y), ++position, move);
+			}
+		}
+	}
+
+	int PathCache::LowerBound(CellIndex from, CellIndex to) const {
+		Position a = grid->ToPosition(from);
+		Position b = grid->ToPosition(to);
+		int dx = std::abs((int)a.x - (int)b.x);
+		int dy = std::abs((int)a.y - (int)b.y);
+		int bound;
+		if(policy.connectivity == FourWay) bound = Policy::Distance<Manhattan>::Get(dx, dy);
+		else if(policy.cost == OctileCost) bound = Policy::Distance<Octile>::Get(dx, dy);
+		else bound = Policy::Distance<Chebyshev>::Get(dx, dy);
+		return costs != nullptr ? bound * std::max<int>(costs->MinCost(), 1) : bound;
+	}
+}
@@ -1,226 +1,282 @@
 #include "pathfinding.hpp"
+#include <cstdio>
+#include <utility>
 
 namespace Pathfinding {
-	Node* Pathfinder::DoStep() {
-		if(openSet.size() == 0) {
-			printf("Open set is empty\n");
-			ResetPath();
-			return startNode;
+	Position Pathfinder::DoStep() {
+		return Step(StepBudget{ 1 });
+	}
+
+	Position Pathfinder::Step(const StepBudget& budget) {
+		if(noPath) {
+			return grid.ToPosition(startNode);
 		}
-		if(pathFound) {
+		if(pathFound && (algorithm != Anytime || search.Finished())) {
 			printf("The path is known\n");
-			return endNode;
+			// Incremental paths are traced from the start towards the end
+			return grid.ToPosition(algorithm == Incremental ? startNode : endNode);
 		}
-
-
-		// Find lowest distance as current node
-		std::vector<Node*>::iterator currentNodeIt = openSet.begin();
-		for(Node* node : openSet) {
-			if(node->fCost() < (*currentNodeIt)->fCost()) {
-				currentNodeIt = std::find(openSet.begin(), openSet.end(), node);
+		if(algorithm == Incremental) {
+			// D* Lite would settle the whole start-less component first
+			if(Separated()) {
+				printf("No path\n");
+				noPath = true;
+				return grid.ToPosition(startNode);
 			}
+			BudgetTracker tracker(budget);
+			CellIndex currentNode;
+			while((currentNode = dstar.Step()) != INVALID_CELL) {
+				if(!tracker.Spend()) return grid.ToPosition(currentNode);
+			}
+			// Up to date. The whole path hangs off the start
+			pathFound = dstar.GetPath().found;
+			if(!pathFound) {
+				printf("No path\n");
+				noPath = true;
+			}
+			return grid.ToPosition(startNode);
 		}
-		Node* currentNode = (*currentNodeIt);
 
-		// Set current node checked
-		closedSet.push_back( (*currentNodeIt));
-		currentNodeIt = openSet.erase(currentNodeIt);
-
-		// Path found
-		if( currentNode == endNode) {
-			pathFound = true;
-			return currentNode;
+		if(search.Exhausted()) {
+			printf("No path\n");
+			noPath = true;
+			return grid.ToPosition(startNode);
 		}
 
-
-		// Go thorough all neighbours and set proper ones open for checking
-		std::vector<Node*> neighbours = GetNeighbourNodes(currentNode);
-		for(Node* neighbour : neighbours ) {
-			neighbour->tested += 1; // For debugging heatmap
-
-			// If iterator = end neighbour is not in openSet
-			std::vector<Node*>::iterator openIt = std::find(openSet.begin(), openSet.end(), neighbour);
-			// Calculate how much it costs to get to the end for each neighbour
-			int newGCost = currentNode->gCost + GetDistance( currentNode, neighbour );
-			if(newGCost < neighbour->gCost || openIt == openSet.end()) {
-				neighbour->gCost = newGCost;
-				neighbour->hCost = GetDistance(neighbour, endNode);
-				neighbour->parent = currentNode;
-
-				// Set neigbour as unchecked
-				if(openIt == openSet.end()) {
-					openSet.push_back(neighbour);
-				}
-			}
-			if(neighbour == endNode) {
-				pathFound = true;
-				return neighbour;
-			}
+		CellIndex currentNode = search.Step(budget);
+		pathFound = search.Found();
+		// Show the best path so far while Anytime mode improves it
+		if(currentNode == INVALID_CELL || (algorithm == Anytime && pathFound)) {
+			return grid.ToPosition(pathFound ? endNode : startNode);
 		}
-
-		return currentNode;
+		return grid.ToPosition(currentNode);
 	}
 
-	void Pathfinder::SetData(std::vector<Pathfinding::Node*> data) {
-		for(Node* node : data) {
-			// Floor
-			if( node->pixel->red == 255 && node->pixel->green == 255 && node->pixel->blue == 255 ) {
-				pathdata.push_back(node);
-			}
-			// Start
-			else if( node->pixel->red == 0 && node->pixel->green == 0 && node->pixel->blue == 255 ) {
-				startNode = node;
+	void Pathfinder::SetData(MapData map) {
+		grid = std::move(map.grid);
+		costs = std::move(map.costs);
+		jumpTable = std::move(map.jumpTable);
+		startNode = map.start;
+		endNode = map.end;
 
-				openSet.push_back(node);
-			}
-			// End
-			else if( node->pixel->red == 255 && node->pixel->green == 0 && node->pixel->blue == 0 ) {
-				endNode = node;
-				pathdata.push_back(node);
-			}
-			// Walls are omitted
-		}
 		// Missing start or end
-		if(startNode == nullptr || endNode == nullptr) {
+		if(startNode == INVALID_CELL || endNode == INVALID_CELL) {
 			printf("ERROR: No Start (Blue) or End (Red) marked. Defaulting to first and last\n");
-			startNode = (*pathdata.begin());
-			endNode = (*pathdata.end()-1);
+			startNode = 0;
+			endNode = (CellIndex)grid.CellCount() - 1;
+			while(startNode < endNode && !grid.IsWalkable(startNode)) startNode++;
+			while(endNode > startNode && !grid.IsWalkable(endNode)) endNode--;
 		}
 
-		startNode->gCost = 0;
-		startNode->hCost = GetDistance(startNode, endNode);
-		endNode->hCost = 0;
-		endNode->gCost = GetDistance(endNode, startNode);
+		flowFieldStale = true;
+		components.Build(grid, GetPolicy().connectivity == EightWay);
+		dstarReady = false;
+		search.SetGrid(&grid);
+		search.SetCosts(&costs);
+		search.SetComponents(&components);
+		cache.SetGrid(&grid);
+		cache.SetCosts(&costs);
+		SetLandmarks(landmarkCount);
 	}
 
-	void Pathfinder::ResetPath() {
-		closedSet.clear();
-		openSet.clear();
-		openSet.push_back(startNode);
-
-		// Reset costs // TODO can be recalculated
-		for(std::vector<Node*>::iterator it = pathdata.begin(); it != pathdata.end(); it++) {
-			(*it)->gCost = 0;
-			(*it)->hCost = 0;
+	void Pathfinder::SetAlgorithm(Algorithm _algorithm) {
+		algorithm = _algorithm;
+		if(algorithm == JumpPointSearchPlus && jumpTable.Empty()) {
+			jumpTable.Build(grid);
 		}
-		startNode->hCost = GetDistance(startNode, endNode);
-		endNode->gCost = GetDistance(endNode, startNode);
-
-		pathFound = false;
-	}
+		search.SetAlgorithm(algorithm, &jumpTable);
 
-	std::vector<Node*> Pathfinder::GetNeighbourNodes(Node* node) {
-		std::vector<Node*> neighbours;
-		for (int x = -1; x <= 1; x++) {
-			for (int y = -1; y <= 1; y++) {
-				if(x == 0 && y == 0) continue; // skip self
-
-				Position checkPos = node->pos;
-				checkPos.x += x;
-				checkPos.y += y;
-
-				if (checkPos.x <= mapSize.width-1 && checkPos.y <= mapSize.height-1) {
-					for(Node* node : pathdata) {
-						if( node->pos == checkPos ) {
-							// Skip closed neighbours
-							std::vector<Node*>::iterator closedIt = std::find(closedSet.begin(),
-													  closedSet.end(),
-													  node);
-							if(closedIt != closedSet.end()) { continue; }
-
-							neighbours.push_back(node);
-						}
-					}
-				}
+		if(algorithm == Incremental) {
+			if(!dstarReady) {
+				dstar.SetGrid(&grid);
+				dstarReady = true;
 			}
+			dstar.Begin(startNode, endNode);
 		}
-		return neighbours;
+		ResetPath();
 	}
 
-	void Pathfinder::SetMapSize(uint width, uint height) {
-		mapSize.width = width;
-		mapSize.height = height;
+	void Pathfinder::SetPolicy(SearchPolicy policy) {
+		bool diagonal = policy.connectivity == EightWay;
+		if(!components.Empty() && components.Diagonal() != diagonal) {
+			components.Build(grid, diagonal);
+		}
+		search.SetPolicy(policy);
+		cache.SetPolicy(policy);
+		ResetPath();
 	}
 
-	Size Pathfinder::GetMapSize() {
-		return mapSize;
+	void Pathfinder::SetAnytimeWeight(double weight) {
+		search.SetAnytimeWeight(weight);
+		ResetPath();
 	}
 
-	Position Pathfinder::GetStartNodePosition() {
-		return startNode->pos;
+	void Pathfinder::SetLandmarks(uint count) {
+		landmarkCount = count;
+		landmarksStale = false;
+		if(count > 0) landmarks.Build(grid, count);
+		else landmarks = Landmarks();
+		search.SetLandmarks(&landmarks);
+		SetAlgorithm(algorithm);
 	}
 
-	Position Pathfinder::GetEndNodePosition() {
-		return endNode->pos;
-	}
+	PathResult Pathfinder::FindPath(Position start, Position end) {
+		if(!grid.IsWalkable(start.x, start.y) || !grid.IsWalkable(end.x, end.y)) {
+			return PathResult();
+		}
+		startNode = grid.Index(start.x, start.y);
+		endNode = grid.Index(end.x, end.y);
 
-	Node* Pathfinder::MoveStart(uint x, uint y) {
-		Position newPos(x, y);
-		if(newPos.x > mapSize.width-1 || newPos.y > mapSize.height-1) {
-			printf("Invalid position\n");
-			return startNode;
+		if(landmarksStale) {
+			landmarks.Build(grid, landmarkCount);
+			search.SetLandmarks(&landmarks);
+			landmarksStale = false;
 		}
 
-		std::vector<Node*>::iterator nodeIt = pathdata.begin();
-		for(; nodeIt != pathdata.end(); nodeIt++) {
-			if( (*nodeIt)->pos == newPos) {
-				startNode = (*nodeIt);
+		PathResult result;
+		if(Separated()) {
+			pathFound = false;
+			noPath = true;
+			return result;
+		}
+		// D* Lite ignores the policy and terrain the cached paths were found with,
+		// first Anytime paths aren't optimal
+		if(algorithm == Incremental) {
+			ResetPath();
+			dstar.Run();
+			result = dstar.GetPath();
+		}
+		else if(algorithm == Anytime) {
+			result = search.Solve(startNode, endNode);
+		}
+		else if(!cache.Lookup(startNode, endNode, result)) {
+			uint64_t version = cache.Version();
+			result = search.Solve(startNode, endNode);
+			cache.Store(startNode, endNode, version, result);
+		}
+		pathFound = result.found;
+		return result;
+	}
+
+	const SearchStats& Pathfinder::GetStats() const {
+		return algorithm == Incremental ? dstar.GetStats() : search.GetStats();
+	}
+
+	void Pathfinder::ResetPath() {
+		pathFound = false;
+		noPath = false;
+		if(algorithm == Incremental) {
+			// D* Lite is rooted at the end, only a new end needs a fresh search
+			if(dstar.GetEnd() != endNode) {
+				dstar.Begin(startNode, endNode);
 			}
+			else {
+				dstar.MoveStart(startNode);
+			}
+			return;
 		}
-		return startNode;
+		search.Begin(startNode, endNode);
 	}
 
-	Node* Pathfinder::MoveEnd(uint x, uint y) {
-		Position newPos(x, y);
-		if(newPos.x > mapSize.width-1 || newPos.y > mapSize.height-1) {
+	void Pathfinder::SetWalkable(uint x, uint y, bool walkable) {
+		if(!grid.InBounds(x, y)) {
 			printf("Invalid position\n");
-			return endNode;
+			return;
 		}
+		CellIndex cell = grid.Index(x, y);
+		// Start and end have to stay on the floor
+		if(cell == startNode || cell == endNode || grid.IsWalkable(cell) == walkable) return;
 
-		std::vector<Node*>::iterator nodeIt = pathdata.begin();
-		for(; nodeIt != pathdata.end(); nodeIt++) {
-			if( (*nodeIt)->pos == newPos) {
-				endNode = (*nodeIt);
-			}
+		pathFound = false;
+		flowFieldStale = true;
+		// Opened walls become plain floor
+		if(walkable && !costs.Empty() && costs.Get(cell) == 0) {
+			costs.Set(cell, 1);
+		}
+		// D* Lite edits the shared grid itself to repair its search
+		if(algorithm == Incremental) dstar.SetWalkable(cell, walkable);
+		else grid.SetWalkable(cell, walkable);
+
+		// Kept current in every mode,
+		// the other algorithms may be selected again after the edit
+		components.SetWalkable(grid, cell, walkable);
+		cache.SetWalkable(cell, walkable);
+		// New walls only make paths longer, the old bounds still hold. Tables that can't be lowered
+		// in place are left out of the searches until the next FindPath builds them again
+		if(walkable && !landmarksStale && !landmarks.Open(grid, cell)) {
+			landmarksStale = true;
+			search.SetLandmarks(nullptr);
 		}
-		return endNode;
+		if(!jumpTable.Empty()) {
+			jumpTable.Build(grid);
+		}
+
+		if(algorithm == Incremental) noPath = false;
+		else ResetPath();
 	}
 
-	int Pathfinder::GetDistance(Node *nodeA, Node *nodeB) {
-		int dstX = abs((int)nodeA->pos.x - (int)nodeB->pos.x);
-		int dstY = abs((int)nodeA->pos.y - (int)nodeB->pos.y);
+	// D* Lite always moves 8-way past corners
+	bool Pathfinder::Separated() const {
+		bool diagonalMoves = algorithm == Incremental || GetPolicy().connectivity == EightWay;
+		return components.Separates(diagonalMoves) && !components.Connected(startNode, endNode);
+	}
 
-		if(dstX > dstY) {
-			return 14 * dstY + 10 * (dstX - dstY);
+	const FlowField& Pathfinder::GetFlowField() {
+		if(flowFieldStale || flowField.GetGoal() != endNode) {
+			flowField.Build(grid, endNode);
+			flowFieldStale = false;
 		}
-		return 14 * dstX + 10 * (dstY - dstX);
+		return flowField;
 	}
 
-	std::vector<Node*> Pathfinder::RetracePath(Node* currentNode) {
-		std::vector<Node*> path;
+	Size Pathfinder::GetMapSize() {
+		return grid.GetSize();
+	}
 
-		while(currentNode != startNode) {
-			path.push_back(currentNode);
-			currentNode = currentNode->parent;
+	NodeState Pathfinder::GetNodeState(uint x, uint y) {
+		if(algorithm == Incremental) {
+			return dstar.GetState(grid.Index(x, y));
 		}
-		path.push_back(startNode);
-		return path;
+		return search.GetState(grid.Index(x, y));
 	}
 
-	Node* Pathfinder::GetStartNode() {
-		return startNode;
+	Position Pathfinder::GetStartNodePosition() {
+		return grid.ToPosition(startNode);
 	}
 
-	Node* Pathfinder::GetEndNode() {
-		return endNode;
+	Position Pathfinder::GetEndNodePosition() {
+		return grid.ToPosition(endNode);
 	}
 
-	Node* Pathfinder::GetNode(uint x, uint y) {
-		for(Node* node : pathdata) {
-			if( node->pos.x == x && node->pos.y == y ) {
-				return node;
-			}
+	Position Pathfinder::MoveStart(uint x, uint y) {
+		if(!grid.InBounds(x, y)) {
+			printf("Invalid position\n");
+			return grid.ToPosition(startNode);
+		}
+
+		// Start can't be moved into a wall
+		if(grid.IsWalkable(x, y)) {
+			startNode = grid.Index(x, y);
+		}
+		return grid.ToPosition(startNode);
+	}
+
+	Position Pathfinder::MoveEnd(uint x, uint y) {
+		if(!grid.InBounds(x, y)) {
+			printf("Invalid position\n");
+			return grid.ToPosition(endNode);
+		}
+
+		if(grid.IsWalkable(x, y)) {
+			endNode = grid.Index(x, y);
+		}
+		return grid.ToPosition(endNode);
+	}
+
+	std::vector<Position> Pathfinder::RetracePath(Position endPos) {
+		if(algorithm == Incremental) {
+			return dstar.RetracePath(grid.Index(endPos.x, endPos.y));
 		}
-		return new Node( 0, 0, new Color(0,0,0) );
+		return search.RetracePath(grid.Index(endPos.x, endPos.y));
 	}
 }
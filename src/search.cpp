@@ -0,0 +1,674 @@
+#include "search.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+
+namespace Pathfinding {
+	namespace {
+		const int NO_PATH_COST = INT32_MAX;
+
+		// Weighted kernels queue cells in buckets, the rest in the heap
+		template <class K>
+		auto& OpenSetOf(SearchSpace& side) {
+			if constexpr(K::WEIGHTED) return side.buckets;
+			else return side.openSet;
+		}
+
+		// Where a straight jump from x along row y of grid, step 1 or -1, stops: the first cell that is
+		// a wall, lies outside the map or has a forced neighbour, a wall beside it with floor beside the
+		// next cell. Reads 64 cells at a time
+		int ScanRow(const Grid& grid, int x, int y, int step) {
+			if(step > 0) {
+				for(int first = x + 1;; first += 64) {
+					uint64_t forced = (~grid.RowBits(first, y - 1) & grid.RowBits(first + 1, y - 1))
+					                  | (~grid.RowBits(first, y + 1) & grid.RowBits(first + 1, y + 1));
+					uint64_t stops = ~grid.RowBits(first, y) | forced;
+					if(stops != 0) return first + std::countr_zero(stops);
+				}
+			}
+			for(int first = x - 64;; first -= 64) {
+				uint64_t forced = (~grid.RowBits(first, y - 1) & grid.RowBits(first - 1, y - 1))
+				                  | (~grid.RowBits(first, y + 1) & grid.RowBits(first - 1, y + 1));
+				uint64_t stops = ~grid.RowBits(first, y) | forced;
+				if(stops != 0) return first + 63 - std::countl_zero(stops);
+			}
+		}
+	}
+
+	void Search::SetGrid(const Grid* _grid) {
+		grid = _grid;
+		columns = Grid();
+		columnsVersion = UINT64_MAX;
+		space.Resize(grid->CellCount());
+		if(backSpace.CellCount() != 0) {
+			backSpace.Resize(grid->CellCount());
+		}
+		AllocateSpaces();
+		startNode = INVALID_CELL;
+		endNode = INVALID_CELL;
+		found = false;
+	}
+
+	void Search::SetAlgorithm(Algorithm _algorithm, const JumpTable* _jumpTable) {
+		algorithm = _algorithm;
+		jumpTable = _jumpTable;
+		// Without a table JPS+ falls back to scanning
+		if(algorithm == JumpPointSearchPlus && (jumpTable == nullptr || jumpTable->Empty())) {
+			algorithm = JumpPointSearch;
+		}
+		// One-off searches gain nothing from D* Lite
+		if(algorithm == Incremental) {
+			algorithm = AStar;
+		}
+		UpdateReopening();
+		AllocateSpaces();
+	}
+
+	void Search::AllocateSpaces() {
+		if(grid == nullptr) return;
+		if(algorithm == Bidirectional && backSpace.CellCount() != grid->CellCount()) {
+			backSpace.Resize(grid->CellCount());
+		}
+		if(costs != nullptr) {
+			space.UseBuckets();
+			if(backSpace.CellCount() != 0) backSpace.UseBuckets();
+		}
+	}
+
+	void Search::SetPolicy(SearchPolicy _policy) {
+		policy = _policy;
+		kernel = &KERNELS[Policy::KernelIndex(policy, costs != nullptr)];
+	}
+
+	void Search::SetCosts(const TerrainCosts* _costs) {
+		costs = _costs != nullptr && !_costs->Empty() ? _costs : nullptr;
+		kernel = &KERNELS[Policy::KernelIndex(policy, costs != nullptr)];
+		AllocateSpaces();
+	}
+
+	void Search::SetComponents(const Components* _components) {
+		components = _components;
+	}
+
+	void Search::SetLandmarks(const Landmarks* _landmarks) {
+		landmarks = _landmarks != nullptr && !_landmarks->Empty() ? _landmarks : nullptr;
+		UpdateReopening();
+	}
+
+	void Search::SetAnytimeWeight(double weight) {
+		anytimeWeight = (int)std::lround(std::max(weight, 1.0) * 16);
+	}
+
+	// Weighted keys close cells before their cheapest path is known, so do scaled landmark tables
+	void Search::UpdateReopening() {
+		reopenClosed = algorithm == Anytime || (landmarks != nullptr && !landmarks->Exact());
+	}
+
+	// No-corner moves connect what 4-way ones do, only corner cutting needs 8-connected labels
+	bool Search::Separated(CellIndex start, CellIndex end) const {
+		return components != nullptr && components->Separates(policy.connectivity == EightWay)
+		       && !components->Connected(start, end);
+	}
+
+	void Search::Begin(CellIndex start, CellIndex end) {
+		space.Reset();
+		stats.Reset();
+		startNode = start;
+		endNode = end;
+		found = false;
+		bestCost = NO_PATH_COST;
+		meetNode = INVALID_CELL;
+		if(algorithm == JumpPointSearch && kernel->jumps && columnsVersion != grid->Version()) {
+			columns = grid->Transposed();
+			columnsVersion = grid->Version();
+		}
+		if(algorithm == Bidirectional) {
+			backSpace.Reset();
+		}
+		if(Separated(startNode, endNode)) {
+			return;
+		}
+
+		// Cells can get cheaper after SetCosts
+		heuristicScale = costs != nullptr ? std::max<int>(costs->MinCost(), 1) : 1;
+		auto heuristic = [&](CellIndex cell, CellIndex target) { return (this->*kernel->heuristic)(cell, target); };
+
+		int hCost = heuristic(startNode, endNode);
+		if(algorithm == Bidirectional) {
+			hCost -= heuristic(startNode, startNode);
+		}
+		PushStart(space, startNode, hCost);
+		stats.Pushed(space.OpenSize());
+
+		if(algorithm == Bidirectional) {
+			PushStart(backSpace, endNode, heuristic(endNode, startNode) - heuristic(endNode, endNode));
+			stats.Pushed(space.OpenSize() + backSpace.OpenSize());
+			if(startNode == endNode) {
+				bestCost = 0;
+				meetNode = startNode;
+			}
+		}
+	}
+
+	void Search::PushStart(SearchSpace& side, CellIndex cell, int hCost) {
+		side.gCost[cell] = 0;
+		side.parent[cell] = INVALID_CELL;
+		side.SetState(cell, Open);
+		if(costs != nullptr) side.buckets.Push(cell, hCost, hCost);
+		else side.openSet.Push(cell, hCost, hCost);
+	}
+
+	CellIndex Search::Step() {
+		switch(algorithm) {
+		case Bidirectional:
+			return (this->*kernel->stepBidirectional)();
+		case JumpPointSearch:
+		case JumpPointSearchPlus:
+			return (this->*kernel->stepJumpPoints)();
+		case Anytime:
+			return (this->*kernel->stepAnytime)();
+		default:
+			return (this->*kernel->step)();
+		}
+	}
+
+	CellIndex Search::Step(const StepBudget& budget) {
+		BudgetTracker tracker(budget);
+		CellIndex lastNode = INVALID_CELL;
+		while(!Finished()) {
+			CellIndex currentNode = Step();
+			if(currentNode != INVALID_CELL) lastNode = currentNode;
+			if(!tracker.Spend()) break;
+		}
+		return lastNode;
+	}
+
+	template <class K>
+	CellIndex Search::StepAStar() {
+		auto& open = OpenSetOf<K>(space);
+		if(open.Empty()) {
+			return INVALID_CELL;
+		}
+
+		// Lowest fCost (ties on hCost) is always on top of the heap
+		CellIndex currentNode = open.Pop();
+		stats.Popped();
+		stats.Expanded();
+
+		// Set current node checked
+		space.SetState(currentNode, Closed);
+
+		// Path found. Checked when popped instead of when generated so the path is optimal
+		if( currentNode == endNode) {
+			found = true;
+			return currentNode;
+		}
+
+		// Go thorough all neighbours and set proper ones open for checking
+		CellIndex neighbours[8];
+		int costs[8];
+		int neighbourCount = GetNeighbourNodes<K>(space, currentNode, neighbours, costs);
+		for(int i = 0; i < neighbourCount; i++) {
+			stats.Generated();
+			Relax<K>(space, currentNode, neighbours[i], costs[i], endNode);
+		}
+
+		return currentNode;
+	}
+
+	template <class K>
+	CellIndex Search::StepJumpPoints() {
+		if constexpr(!K::JUMPS) {
+			return StepAStar<K>();
+		}
+		else {
+			if(space.openSet.Empty()) {
+				return INVALID_CELL;
+			}
+
+			CellIndex currentNode = space.openSet.Pop();
+			stats.Popped();
+			stats.Expanded();
+			space.SetState(currentNode, Closed);
+
+			if(currentNode == endNode) {
+				found = true;
+				return currentNode;
+			}
+
+			CellIndex successors[8];
+			int successorCount = GetJumpPoints(currentNode, successors);
+			for(int i = 0; i < successorCount; i++) {
+				stats.Generated();
+				Relax<K>(space, currentNode, successors[i], GetDistance(currentNode, successors[i]), endNode);
+			}
+
+			return currentNode;
+		}
+	}
+
+	// Cells are queued on g + weight * h, so the first path is found fast but may cost up to weight
+	// times the optimal one. Closed cells reopen when reached cheaper, and anything that can't beat
+	// the latest path, g + h >= bestCost, is dropped. Every later path is cheaper, and once the open
+	// set runs out nothing cheaper is left
+	template <class K>
+	CellIndex Search::StepAnytime() {
+		auto& open = OpenSetOf<K>(space);
+		CellIndex currentNode;
+		do {
+			if(open.Empty()) {
+				return INVALID_CELL;
+			}
+			currentNode = open.Pop();
+			stats.Popped();
+			space.SetState(currentNode, Closed);
+		} while(bestCost != NO_PATH_COST && (int64_t)space.gCost[currentNode] + Heuristic<K>(currentNode, endNode) >= bestCost);
+		stats.Expanded();
+
+		if(currentNode == endNode) {
+			found = true;
+			bestCost = space.gCost[endNode];
+			return currentNode;
+		}
+
+		CellIndex neighbours[8];
+		int costs[8];
+		int neighbourCount = GetNeighbourNodes<K>(space, currentNode, neighbours, costs);
+		for(int i = 0; i < neighbourCount; i++) {
+			stats.Generated();
+			Relax<K>(space, currentNode, neighbours[i], costs[i], endNode);
+		}
+		return currentNode;
+	}
+
+	// Expands the side with fewer open cells. Both searches use the average potential
+	//   forward (h(cell, end) - h(cell, start)) / 2, backward the negation
+	// which makes them Dijkstra on the same reduced edge costs, so the meeting point is
+	// optimal once the smallest keys of both sides add up to its cost. Keys are doubled to stay integers
+	template <class K>
+	CellIndex Search::StepBidirectional() {
+		auto& forwardOpen = OpenSetOf<K>(space);
+		auto& backwardOpen = OpenSetOf<K>(backSpace);
+		if(bestCost != NO_PATH_COST) {
+			// A side that ran out has seen every cell it can reach, nothing cheaper is left
+			if(forwardOpen.Empty() || backwardOpen.Empty()
+			   || (int64_t)forwardOpen.TopFCost() + backwardOpen.TopFCost() >= 2 * (int64_t)bestCost) {
+				found = true;
+				return endNode;
+			}
+		}
+		if(forwardOpen.Empty() || backwardOpen.Empty()) {
+			return INVALID_CELL;
+		}
+
+		bool forward = forwardOpen.Size() <= backwardOpen.Size();
+		SearchSpace& side = forward ? space : backSpace;
+		const SearchSpace& other = forward ? backSpace : space;
+		CellIndex target = forward ? endNode : startNode;
+
+		CellIndex currentNode = OpenSetOf<K>(side).Pop();
+		stats.Popped();
+		stats.Expanded();
+		side.SetState(currentNode, Closed);
+
+		CellIndex neighbours[8];
+		int costs[8];
+		int neighbourCount = GetNeighbourNodes<K>(side, currentNode, neighbours, costs);
+		for(int i = 0; i < neighbourCount; i++) {
+			CellIndex neighbour = neighbours[i];
+			stats.Generated();
+			if(!Relax<K>(side, currentNode, neighbour, costs[i], target)) continue;
+
+			// Both searches got here, that's a whole path
+			if(other.GetState(neighbour) != Unvisited) {
+				int pathCost = side.gCost[neighbour] + other.gCost[neighbour];
+				if(pathCost < bestCost) {
+					bestCost = pathCost;
+					meetNode = neighbour;
+				}
+			}
+		}
+		return currentNode;
+	}
+
+	template <class K>
+	bool Search::Relax(SearchSpace& side, CellIndex from, CellIndex to, int cost, CellIndex target) {
+		NodeState state = side.GetState(to);
+		// Calculate how much it costs to get to the end for each neighbour
+		int newGCost = side.gCost[from] + cost;
+		if(state != Unvisited && newGCost >= side.gCost[to]) return false;
+
+		// Not stored per cell. Queued cells give it back from their key, g + h or 2g + h in Bidirectional
+		// mode, the rest recompute it
+		int hCost;
+		if(state == Open && algorithm != Anytime) {
+			hCost = OpenSetOf<K>(side).GetFCost(to) - side.gCost[to] * (algorithm == Bidirectional ? 2 : 1);
+		}
+		else {
+			hCost = algorithm == Bidirectional ? Potential<K>(to, target) : Heuristic<K>(to, target);
+		}
+		// No cheaper path to the end through here than the one Anytime mode already has
+		if(algorithm == Anytime && (int64_t)newGCost + hCost >= bestCost) return false;
+		side.gCost[to] = newGCost;
+		side.parent[to] = from;
+
+		int fCost = newGCost + hCost;
+		if(algorithm == Bidirectional) fCost += newGCost;
+		else if(algorithm == Anytime) fCost = newGCost + hCost * anytimeWeight / 16;
+		// Set neigbour as unchecked or move it up in the queue
+		if(state != Open) {
+			if(state == Closed) stats.Reopened();
+			side.SetState(to, Open);
+			OpenSetOf<K>(side).Push(to, fCost, hCost);
+			stats.Pushed(OpenSetOf<K>(space).Size() + (algorithm == Bidirectional ? OpenSetOf<K>(backSpace).Size() : 0));
+		}
+		else {
+			OpenSetOf<K>(side).DecreaseKey(to, fCost, hCost);
+			stats.Updated();
+		}
+		return true;
+	}
+
+	bool Search::Exhausted() const {
+		if(algorithm == Bidirectional) {
+			// A known meeting point still has to be confirmed by the next step
+			return !found && bestCost == NO_PATH_COST && (space.OpenEmpty() || backSpace.OpenEmpty());
+		}
+		return space.OpenEmpty();
+	}
+
+	NodeState Search::GetState(CellIndex cell) const {
+		NodeState state = space.GetState(cell);
+		if(algorithm == Bidirectional) {
+			state = std::max(state, backSpace.GetState(cell));
+		}
+		return state;
+	}
+
+	bool Search::Run() {
+		while(!found && !Exhausted()) {
+			Step();
+		}
+		return found;
+	}
+
+	PathResult Search::Solve(CellIndex start, CellIndex end) {
+		PathResult result;
+		// Nothing is searched, the cells and counters of the previous query mustn't show through
+		if(!grid->IsWalkable(start) || !grid->IsWalkable(end) || Separated(start, end)) {
+			space.Reset();
+			if(algorithm == Bidirectional) backSpace.Reset();
+			stats.Reset();
+			return result;
+		}
+
+		Stats::TimePoint phaseStart = stats.Now();
+		Begin(start, end);
+		stats.AddTime(&SearchStats::setupNs, phaseStart);
+
+		phaseStart = stats.Now();
+		bool reached = Run();
+		stats.AddTime(&SearchStats::searchNs, phaseStart);
+		if(!reached) {
+			result.stats = stats.Get();
+			return result;
+		}
+
+		phaseStart = stats.Now();
+		result.found = true;
+		result.cost = algorithm == Bidirectional ? bestCost : space.gCost[endNode];
+		result.path = RetracePath(endNode);
+		std::reverse(result.path.begin(), result.path.end());
+		stats.AddTime(&SearchStats::pathNs, phaseStart);
+		result.stats = stats.Get();
+		return result;
+	}
+
+	std::vector<Position> Search::RetracePath(CellIndex currentNode) const {
+		if(algorithm != Bidirectional) {
+			return RetraceChain(space, currentNode, startNode);
+		}
+		if(found && currentNode == endNode) {
+			// End to meeting cell along the backward search, then on to the start
+			std::vector<Position> path = RetraceChain(backSpace, meetNode, endNode);
+			std::reverse(path.begin(), path.end());
+			std::vector<Position> forwardHalf = RetraceChain(space, meetNode, startNode);
+			path.insert(path.end(), forwardHalf.begin() + 1, forwardHalf.end());
+			return path;
+		}
+		if(space.GetState(currentNode) == Unvisited && backSpace.GetState(currentNode) != Unvisited) {
+			return RetraceChain(backSpace, currentNode, endNode);
+		}
+		return RetraceChain(space, currentNode, startNode);
+	}
+
+	std::vector<Position> Search::RetraceChain(const SearchSpace& side, CellIndex currentNode, CellIndex root) const {
+		std::vector<Position> path;
+
+		while(currentNode != root && currentNode != INVALID_CELL) {
+			CellIndex parentNode = side.GetState(currentNode) == Unvisited ? INVALID_CELL : side.parent[currentNode];
+			path.push_back(grid->ToPosition(currentNode));
+			if(parentNode == INVALID_CELL) break;
+
+			// Parents are adjacent in A*, jump points are on a straight or diagonal line
+			Position pos = grid->ToPosition(currentNode);
+			Position parentPos = grid->ToPosition(parentNode);
+			int dx = (parentPos.x > pos.x) - (parentPos.x < pos.x);
+			int dy = (parentPos.y > pos.y) - (parentPos.y < pos.y);
+			pos.x += dx;
+			pos.y += dy;
+			while(pos != parentPos) {
+				path.push_back(pos);
+				pos.x += dx;
+				pos.y += dy;
+			}
+			currentNode = parentNode;
+		}
+		path.push_back(grid->ToPosition(root));
+		return path;
+	}
+
+	template <class K>
+	int Search::GetNeighbourNodes(SearchSpace& side, CellIndex cell, CellIndex* neighbours, int* moveCosts) {
+		int count = 0;
+		Position pos = grid->ToPosition(cell);
+		int width = (int)grid->Width();
+		[[maybe_unused]] bool backward = &side == &backSpace;
+		K::ForEachMove([&](Policy::Move move) {
+			int checkX = (int)pos.x + move.dx;
+			int checkY = (int)pos.y + move.dy;
+			if(!grid->InBounds(checkX, checkY)) return;
+
+			CellIndex neighbour = cell + move.dx + move.dy * width;
+			// Skip walls and closed neighbours
+			if(!grid->IsWalkable(neighbour)) return;
+			if(!K::Moves::Allowed(*grid, (int)pos.x, (int)pos.y, move)) return;
+			if(!reopenClosed && side.GetState(neighbour) == Closed) return;
+
+			neighbours[count] = neighbour;
+			if constexpr(K::WEIGHTED) {
+				moveCosts[count++] = K::Cost::Of(move) * costs->Get(backward ? cell : neighbour);
+			}
+			else {
+				moveCosts[count++] = K::Cost::Of(move);
+			}
+		});
+		return count;
+	}
+
+	int Search::GetJumpPoints(CellIndex cell, CellIndex* successors) {
+		Position pos = grid->ToPosition(cell);
+		int x = (int)pos.x;
+		int y = (int)pos.y;
+
+		// Prune neighbours that some other path reaches at least as cheaply.
+		// Only the direction we arrived from matters
+		int directions[8][2];
+		int directionCount = 0;
+		CellIndex parentNode = space.parent[cell];
+		if(parentNode == INVALID_CELL) {
+			for (int dx = -1; dx <= 1; dx++) {
+				for (int dy = -1; dy <= 1; dy++) {
+					if(dx == 0 && dy == 0) continue;
+					directions[directionCount][0] = dx;
+					directions[directionCount++][1] = dy;
+				}
+			}
+		}
+		else {
+			Position parentPos = grid->ToPosition(parentNode);
+			int dx = (x > (int)parentPos.x) - (x < (int)parentPos.x);
+			int dy = (y > (int)parentPos.y) - (y < (int)parentPos.y);
+
+			auto add = [&](int addX, int addY) {
+				directions[directionCount][0] = addX;
+				directions[directionCount++][1] = addY;
+			};
+
+			if(dx != 0 && dy != 0) {
+				add(dx, dy);
+				add(dx, 0);
+				add(0, dy);
+				// Forced neighbours
+				if(!IsOpen(*grid, x - dx, y)) add(-dx, dy);
+				if(!IsOpen(*grid, x, y - dy)) add(dx, -dy);
+			}
+			else if(dx != 0) {
+				add(dx, 0);
+				if(!IsOpen(*grid, x, y + 1)) add(dx, 1);
+				if(!IsOpen(*grid, x, y - 1)) add(dx, -1);
+			}
+			else {
+				add(0, dy);
+				if(!IsOpen(*grid, x + 1, y)) add(1, dy);
+				if(!IsOpen(*grid, x - 1, y)) add(-1, dy);
+			}
+		}
+
+		int count = 0;
+		for(int i = 0; i < directionCount; i++) {
+			CellIndex jumpPoint = Jump(x, y, directions[i][0], directions[i][1]);
+			if(jumpPoint == INVALID_CELL) continue;
+
+			if(!reopenClosed && space.GetState(jumpPoint) == Closed) continue;
+
+			successors[count++] = jumpPoint;
+		}
+		return count;
+	}
+
+	// Moves from (x, y) along (dx, dy) until reaching a jump point. INVALID_CELL when hitting a wall
+	CellIndex Search::Jump(int x, int y, int dx, int dy) {
+		if(dx == 0 || dy == 0) {
+			return algorithm == JumpPointSearchPlus ? JumpStraightTable(x, y, dx, dy) : JumpStraight(x, y, dx, dy);
+		}
+
+		Position end = grid->ToPosition(endNode);
+		while(true) {
+			x += dx;
+			y += dy;
+			if(!IsOpen(*grid, x, y)) return INVALID_CELL;
+			if((uint)x == end.x && (uint)y == end.y) return endNode;
+
+			// Forced neighbours
+			if((!IsOpen(*grid, x - dx, y) && IsOpen(*grid, x - dx, y + dy))
+			   || (!IsOpen(*grid, x, y - dy) && IsOpen(*grid, x + dx, y - dy))) {
+				return grid->Index(x, y);
+			}
+
+			// A diagonal step is a jump point if either straight move from it reaches one
+			if(Jump(x, y, dx, 0) != INVALID_CELL || Jump(x, y, 0, dy) != INVALID_CELL) {
+				return grid->Index(x, y);
+			}
+		}
+	}
+
+	// Scans whole words of rows, or of the transposed grid's rows for vertical jumps
+	CellIndex Search::JumpStraight(int x, int y, int dx, int dy) {
+		Position end = grid->ToPosition(endNode);
+		int stop = dy == 0 ? ScanRow(*grid, x, y, dx) : ScanRow(columns, y, x, dy);
+		int stopX = dy == 0 ? stop : x;
+		int stopY = dy == 0 ? y : stop;
+		bool open = IsOpen(*grid, stopX, stopY);
+
+		// The end may come before the stop, or be the stop itself
+		bool endOnLine = dy == 0 ? (int)end.y == y : (int)end.x == x;
+		int from = dy == 0 ? x : y;
+		int endAt = dy == 0 ? (int)end.x : (int)end.y;
+		int step = dx + dy;
+		if(endOnLine && (endAt - from) * step > 0 && ((stop - endAt) * step > 0 || (endAt == stop && open))) {
+			return endNode;
+		}
+		return open ? grid->Index(stopX, stopY) : INVALID_CELL;
+	}
+
+	CellIndex Search::JumpStraightTable(int x, int y, int dx, int dy) {
+		JumpTable::Direction direction = JumpTable::ToDirection(dx, dy);
+		Position end = grid->ToPosition(endNode);
+
+		while(true) {
+			int16_t distance = jumpTable->Get(grid->Index(x, y), direction);
+			int steps = distance == JumpTable::FAR ? JumpTable::FAR_STEPS : abs(distance);
+
+			// The table doesn't know the goal, stop on it if it's on this stretch
+			int goalSteps = dx != 0 ? ((int)end.x - x) * dx : ((int)end.y - y) * dy;
+			bool goalOnLine = dx != 0 ? (int)end.y == y : (int)end.x == x;
+			if(goalOnLine && goalSteps > 0 && goalSteps <= steps) return endNode;
+
+			if(distance == JumpTable::FAR) {
+				x += dx * steps;
+				y += dy * steps;
+				continue;
+			}
+			if(distance > 0) return grid->Index(x + dx * steps, y + dy * steps);
+			return INVALID_CELL;
+		}
+	}
+
+	template <class K>
+	int Search::Heuristic(CellIndex cell, CellIndex target) const {
+		Position pos = grid->ToPosition(cell);
+		Position targetPos = grid->ToPosition(target);
+		int estimate = K::Distance::Get(abs((int)pos.x - (int)targetPos.x), abs((int)pos.y - (int)targetPos.y));
+		// Rounded landmark bounds aren't consistent, Bidirectional mode relies on that
+		if(K::LANDMARKS && landmarks != nullptr && (algorithm != Bidirectional || landmarks->Exact())) {
+			estimate = std::max(estimate, landmarks->LowerBound(cell, target));
+		}
+		// Every cell costs at least the cheapest terrain
+		if constexpr(K::WEIGHTED) {
+			estimate *= heuristicScale;
+		}
+		return estimate;
+	}
+
+	// Twice the average potential towards target, the other end being the source
+	template <class K>
+	int Search::Potential(CellIndex cell, CellIndex target) const {
+		CellIndex source = target == endNode ? startNode : endNode;
+		return Heuristic<K>(cell, target) - Heuristic<K>(cell, source);
+	}
+
+	int Search::GetDistance(CellIndex cellA, CellIndex cellB) const {
+		Position posA = grid->ToPosition(cellA);
+		Position posB = grid->ToPosition(cellB);
+		int dstX = abs((int)posA.x - (int)posB.x);
+		int dstY = abs((int)posA.y - (int)posB.y);
+
+		if(dstX > dstY) {
+			return 14 * dstY + 10 * (dstX - dstY);
+		}
+		return 14 * dstX + 10 * (dstY - dstX);
+	}
+
+	template <class K>
+	constexpr Search::Kernel Search::MakeKernel() {
+		return Kernel{ &Search::StepAStar<K>, &Search::StepBidirectional<K>, &Search::StepJumpPoints<K>, &Search::StepAnytime<K>,
+		               &Search::Heuristic<K>, K::JUMPS };
+	}
+
+	// Indexed by Policy::KernelIndex
+	const std::array<Search::Kernel, Policy::KERNEL_COUNT> Search::KERNELS = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<Kernel, sizeof...(I)>{ MakeKernel<Policy::KernelAt<I>>()... };
+	}(std::make_index_sequence<Policy::KERNEL_COUNT>{});
+}
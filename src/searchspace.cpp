@@ -0,0 +1,32 @@
+#include "searchspace.hpp"
+
+namespace Pathfinding {
+	void SearchSpace::Resize(size_t cellCount) {
+		gCost.Assign(cellCount);
+		parent.Assign(cellCount);
+		stamp.Assign(cellCount);
+		currentGeneration = 0;
+		openSet.Resize(cellCount);
+		if(buckets.CellCount() != 0) {
+			buckets.Resize(cellCount);
+		}
+	}
+
+	void SearchSpace::UseBuckets() {
+		if(buckets.CellCount() != CellCount()) {
+			buckets.Resize(CellCount());
+		}
+	}
+
+	void SearchSpace::Reset() {
+		openSet.Clear();
+		buckets.Clear();
+
+		// Stamps would become ambiguous after wrapping, clear them once every 2 billion searches
+		if(currentGeneration > UINT32_MAX - 2 * Closed) {
+			stamp.Assign(stamp.size());
+			currentGeneration = 0;
+		}
+		currentGeneration += Closed;
+	}
+}
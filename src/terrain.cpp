@@ -0,0 +1,40 @@
+#include "terrain.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace Pathfinding {
+	bool LoadPalette(const std::string& path, TerrainPalette& palette) {
+		std::ifstream file(path);
+		if(!file) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			return false;
+		}
+
+		palette.clear();
+		std::string line;
+		int lineNumber = 0;
+		while(std::getline(file, line)) {
+			lineNumber++;
+			std::istringstream fields(line);
+			std::string first;
+			if(!(fields >> first) || first[0] == '#') continue;
+
+			fields.str(line);
+			fields.clear();
+			int red, green, blue, cost;
+			if(!(fields >> red >> green >> blue >> cost) || red < 0 || red > 255 || green < 0 || green > 255
+			   || blue < 0 || blue > 255 || cost < 0 || cost > 255) {
+				printf("ERROR: %s:%d: expected \"red green blue cost\" with values 0-255\n", path.c_str(), lineNumber);
+				return false;
+			}
+			palette.push_back(TerrainType{ (uint8_t)red, (uint8_t)green, (uint8_t)blue, (uint8_t)cost });
+		}
+		return true;
+	}
+
+	void TerrainCosts::Resize(size_t cellCount) {
+		costs.assign(cellCount, 0);
+		minCost = UINT8_MAX;
+	}
+}
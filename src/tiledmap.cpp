@@ -0,0 +1,284 @@
+#include "tiledmap.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Pathfinding {
+	namespace {
+		const char TILED_MAGIC[8] = { 'P', 'F', 'T', 'I', 'L', 'E', 'S', 0 };
+		constexpr uint32_t TILED_VERSION = 1;
+		constexpr uint MIN_TILE_SIZE = 64;
+		constexpr uint MAX_TILE_SIZE = 4096;
+		constexpr size_t MIN_RESIDENT_TILES = 9;
+
+		struct TiledHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t tileSize;
+			uint32_t startX;
+			uint32_t startY;
+			uint32_t endX;
+			uint32_t endY;
+			uint64_t tilesOffset;
+			uint8_t reserved[16];
+		};
+		static_assert(sizeof(TiledHeader) == 64, "Tiled map header must stay 64 bytes");
+
+		bool ValidTileSize(uint tileSize) {
+			return tileSize >= MIN_TILE_SIZE && tileSize <= MAX_TILE_SIZE && std::has_single_bit(tileSize);
+		}
+	}
+
+	bool SaveTiledMap(const std::string& path, const MapData& map, uint tileSize) {
+		const Grid& grid = map.grid;
+		Position start = map.start != INVALID_CELL ? grid.ToPosition(map.start) : Position{ UINT32_MAX, UINT32_MAX };
+		Position end = map.end != INVALID_CELL ? grid.ToPosition(map.end) : Position{ UINT32_MAX, UINT32_MAX };
+		return SaveTiledMap(path, grid.Width(), grid.Height(), tileSize, start, end, [&](uint tileX, uint tileY, Grid& tile) {
+			for(uint y = 0; y < tileSize; y++) {
+				for(uint x = 0; x < tileSize; x++) {
+					if(grid.IsWalkable(tileX * tileSize + x, tileY * tileSize + y)) {
+						tile.SetWalkable(tile.Index(x, y), true);
+					}
+				}
+			}
+		});
+	}
+
+	bool SaveTiledMap(const std::string& path, uint width, uint height, uint tileSize, Position start, Position end,
+	                  const TileFiller& fill) {
+		if(std::endian::native != std::endian::little) {
+			printf("ERROR: Tiled maps are only supported on little-endian machines\n");
+			return false;
+		}
+		if(!ValidTileSize(tileSize)) {
+			printf("ERROR: Tile size must be a power of two from %u to %u\n", MIN_TILE_SIZE, MAX_TILE_SIZE);
+			return false;
+		}
+		uint tileColumns = (width + tileSize - 1) / tileSize;
+		uint tileRows = (height + tileSize - 1) / tileSize;
+		if(width == 0 || height == 0 || (uint64_t)tileColumns * tileRows >= UINT32_MAX) {
+			printf("ERROR: Invalid tiled map size %ux%u\n", width, height);
+			return false;
+		}
+
+		TiledHeader header = {};
+		memcpy(header.magic, TILED_MAGIC, sizeof(header.magic));
+		header.version = TILED_VERSION;
+		header.width = width;
+		header.height = height;
+		header.tileSize = tileSize;
+		header.startX = start.x;
+		header.startY = start.y;
+		header.endX = end.x;
+		header.endY = end.y;
+		header.tilesOffset = sizeof(TiledHeader);
+
+		std::ofstream file(path, std::ios::binary);
+		if(!file) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			return false;
+		}
+		file.write((const char*)&header, sizeof(header));
+
+		Grid tile;
+		for(uint tileY = 0; tileY < tileRows; tileY++) {
+			for(uint tileX = 0; tileX < tileColumns; tileX++) {
+				tile.Resize(tileSize, tileSize);
+				fill(tileX, tileY, tile);
+				// Edge tiles hang over the map, keep that part walled
+				uint usedWidth = std::min(tileSize, width - tileX * tileSize);
+				uint usedHeight = std::min(tileSize, height - tileY * tileSize);
+				for(uint y = 0; y < tileSize; y++) {
+					for(uint x = y < usedHeight ? usedWidth : 0; x < tileSize; x++) {
+						tile.SetWalkable(tile.Index(x, y), false);
+					}
+				}
+				file.write((const char*)tile.Bits(), tile.WordCount() * sizeof(uint64_t));
+			}
+		}
+		if(!file) {
+			printf("ERROR: Could not write %s\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool IsTiledMap(const std::string& path) {
+		char magic[sizeof(TILED_MAGIC)] = {};
+		std::ifstream file(path, std::ios::binary);
+		file.read(magic, sizeof(magic));
+		return memcmp(magic, TILED_MAGIC, sizeof(magic)) == 0;
+	}
+
+	TiledMap::~TiledMap() {
+		Close();
+	}
+
+	bool TiledMap::Open(const std::string& path, size_t memoryLimit) {
+		Close();
+		if(std::endian::native != std::endian::little) {
+			printf("ERROR: Tiled maps are only supported on little-endian machines\n");
+			return false;
+		}
+
+		TiledHeader header;
+		uint64_t fileSize = 0;
+#ifdef __unix__
+		file = open(path.c_str(), O_RDONLY);
+		struct stat info;
+		if(file < 0 || fstat(file, &info) != 0) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			Close();
+			return false;
+		}
+		fileSize = (uint64_t)info.st_size;
+		bool headerRead = fileSize >= sizeof(header) && pread(file, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+#else
+		file.open(path, std::ios::binary | std::ios::ate);
+		if(!file) {
+			printf("ERROR: Could not open %s\n", path.c_str());
+			return false;
+		}
+		fileSize = (uint64_t)file.tellg();
+		file.seekg(0);
+		bool headerRead = fileSize >= sizeof(header) && file.read((char*)&header, sizeof(header));
+#endif
+		if(!headerRead || memcmp(header.magic, TILED_MAGIC, sizeof(header.magic)) != 0) {
+			printf("ERROR: %s is not a tiled map\n", path.c_str());
+			Close();
+			return false;
+		}
+		if(header.version != TILED_VERSION) {
+			printf("ERROR: %s: unsupported tiled map version %u\n", path.c_str(), header.version);
+			Close();
+			return false;
+		}
+
+		bool valid = header.width > 0 && header.height > 0 && ValidTileSize(header.tileSize)
+			&& header.tilesOffset >= sizeof(header) && header.tilesOffset <= fileSize;
+		uint64_t tileColumnCount = valid ? (header.width + (uint64_t)header.tileSize - 1) / header.tileSize : 0;
+		uint64_t tileRowCount = valid ? (header.height + (uint64_t)header.tileSize - 1) / header.tileSize : 0;
+		uint64_t tileBytes = (uint64_t)header.tileSize * header.tileSize / 8;
+		valid = valid && tileColumnCount * tileRowCount < UINT32_MAX
+			&& tileColumnCount * tileRowCount * tileBytes <= fileSize - header.tilesOffset;
+		if(!valid) {
+			printf("ERROR: %s is truncated or corrupt\n", path.c_str());
+			Close();
+			return false;
+		}
+
+		size = Size{ header.width, header.height };
+		tileShift = (uint)std::countr_zero(header.tileSize);
+		tileMask = header.tileSize - 1;
+		tileColumns = (uint)tileColumnCount;
+		tileRows = (uint)tileRowCount;
+		tileCount = tileColumns * tileRows;
+		tileWords = tileBytes / sizeof(uint64_t);
+		tilesOffset = header.tilesOffset;
+		start = Position{ header.startX, header.startY };
+		end = Position{ header.endX, header.endY };
+		maxSlots = std::max(MIN_RESIDENT_TILES, memoryLimit / tileBytes);
+		tileSlots.assign(tileCount, NO_SLOT);
+		return true;
+	}
+
+	void TiledMap::Close() {
+#ifdef __unix__
+		if(file >= 0) close(file);
+		file = -1;
+#else
+		file.close();
+#endif
+		size = Size{ 0, 0 };
+		tileCount = 0;
+		tileSlots.clear();
+		slots.clear();
+		newest = NO_SLOT;
+		oldest = NO_SLOT;
+		currentTile = NO_SLOT;
+		currentBits = nullptr;
+		loads = 0;
+		evictions = 0;
+	}
+
+	void TiledMap::Use(uint32_t tile) const {
+		uint32_t slot = tileSlots[tile];
+		if(slot == NO_SLOT) {
+			if(slots.size() < maxSlots) {
+				slot = (uint32_t)slots.size();
+				slots.emplace_back();
+				slots.back().bits.resize(tileWords);
+			}
+			else {
+				// The current tile was touched last, it's never the one to go
+				slot = oldest;
+				tileSlots[slots[slot].tile] = NO_SLOT;
+				evictions++;
+			}
+			slots[slot].tile = tile;
+			tileSlots[tile] = slot;
+			Load(tile, slots[slot].bits.data());
+		}
+		Touch(slot);
+		currentTile = tile;
+		currentBits = slots[slot].bits.data();
+	}
+
+	void TiledMap::Load(uint32_t tile, uint64_t* bits) const {
+		loads++;
+		uint64_t offset = tilesOffset + (uint64_t)tile * TileBytes();
+#ifdef __unix__
+		size_t done = 0;
+		while(done < TileBytes()) {
+			ssize_t count = pread(file, (char*)bits + done, TileBytes() - done, (off_t)(offset + done));
+			if(count <= 0) break;
+			done += (size_t)count;
+		}
+		bool read = done == TileBytes();
+#else
+		file.clear();
+		file.seekg((std::streamoff)offset);
+		bool read = (bool)file.read((char*)bits, TileBytes());
+#endif
+		if(!read) {
+			printf("ERROR: Could not read tile %u, treating it as walls\n", tile);
+			std::fill(bits, bits + tileWords, 0);
+		}
+	}
+
+	void TiledMap::Prefetch(int tileX, int tileY) const {
+		if(tileX < 0 || tileY < 0 || (uint)tileX >= tileColumns || (uint)tileY >= tileRows) return;
+		uint32_t tile = (uint32_t)tileX + (uint32_t)tileY * tileColumns;
+		if(tileSlots[tile] != NO_SLOT) return;
+#ifdef __unix__
+		posix_fadvise(file, (off_t)(tilesOffset + (uint64_t)tile * TileBytes()), (off_t)TileBytes(), POSIX_FADV_WILLNEED);
+#endif
+	}
+
+	void TiledMap::Touch(uint32_t slot) const {
+		if(newest == slot) return;
+		Unlink(slot);
+		slots[slot].older = newest;
+		if(newest != NO_SLOT) slots[newest].newer = slot;
+		newest = slot;
+		if(oldest == NO_SLOT) oldest = slot;
+	}
+
+	void TiledMap::Unlink(uint32_t slot) const {
+		Slot& entry = slots[slot];
+		if(entry.newer != NO_SLOT) slots[entry.newer].older = entry.older;
+		else if(newest == slot) newest = entry.older;
+		if(entry.older != NO_SLOT) slots[entry.older].newer = entry.newer;
+		else if(oldest == slot) oldest = entry.newer;
+		entry.newer = NO_SLOT;
+		entry.older = NO_SLOT;
+	}
+}
@@ -0,0 +1,191 @@
+#include "tiledsearch.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+namespace Pathfinding {
+	namespace {
+		size_t Hash(uint64_t key) {
+			return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 17);
+		}
+
+		int Sign(int value) {
+			return (value > 0) - (value < 0);
+		}
+	}
+
+	void TiledSearch::SetMap(const TiledMap* _map) {
+		map = _map;
+	}
+
+	void TiledSearch::SetPolicy(SearchPolicy _policy) {
+		policy = _policy;
+		kernel = &KERNELS[Policy::KernelIndex(policy, false)];
+	}
+
+	PathResult TiledSearch::Solve(Position start, Position end) {
+		return (this->*(*kernel))(start, end);
+	}
+
+	template <class K>
+	PathResult TiledSearch::SolveWith(Position start, Position end) {
+		PathResult result;
+		if(!IsOpen(*map, start.x, start.y) || !IsOpen(*map, end.x, end.y)) {
+			return result;
+		}
+
+		stats.Reset();
+		Stats::TimePoint phaseStart = stats.Now();
+		// A big search shouldn't keep its table for the following small ones
+		nodes.assign(INITIAL_NODES, Node());
+		nodeCount = 0;
+		open.clear();
+
+		uint64_t width = map->Width();
+		auto heuristic = [&](uint x, uint y) {
+			return K::Distance::Get(std::abs((int)x - (int)end.x), std::abs((int)y - (int)end.y));
+		};
+		// Lowest fCost first, ties on hCost like OpenSet
+		auto worse = [](const OpenEntry& a, const OpenEntry& b) {
+			return a.fCost > b.fCost || (a.fCost == b.fCost && a.hCost > b.hCost);
+		};
+
+		uint64_t startKey = start.x + start.y * width;
+		Node& startNode = GetNode(startKey);
+		startNode.gCost = 0;
+		startNode.state = Open;
+		int startH = heuristic(start.x, start.y);
+		open.push_back(OpenEntry{ startH, startH, startKey });
+		stats.Pushed(open.size());
+		stats.AddTime(&SearchStats::setupNs, phaseStart);
+
+		phaseStart = stats.Now();
+		uint tileShift = (uint)std::countr_zero(map->TileSize());
+		int endTileX = (int)(end.x >> tileShift);
+		int endTileY = (int)(end.y >> tileShift);
+		int lastTileX = -1;
+		int lastTileY = -1;
+		uint64_t endKey = end.x + end.y * width;
+		bool reached = false;
+		bool limitHit = false;
+
+		while(!open.empty() && !limitHit) {
+			std::pop_heap(open.begin(), open.end(), worse);
+			OpenEntry top = open.back();
+			open.pop_back();
+			stats.Popped();
+
+			Node& current = GetNode(top.key);
+			// A cheaper way to the cell was queued after this entry
+			if(current.state == Closed || top.fCost - top.hCost != current.gCost) continue;
+			current.state = Closed;
+			stats.Expanded();
+			if(top.key == endKey) {
+				reached = true;
+				break;
+			}
+
+			int gCost = current.gCost;
+			uint x = (uint)(top.key % width);
+			uint y = (uint)(top.key / width);
+
+			// The search front moves towards the end, have the tiles on that side read in meanwhile
+			int tileX = (int)(x >> tileShift);
+			int tileY = (int)(y >> tileShift);
+			if(tileX != lastTileX || tileY != lastTileY) {
+				lastTileX = tileX;
+				lastTileY = tileY;
+				int stepX = Sign(endTileX - tileX);
+				int stepY = Sign(endTileY - tileY);
+				if(stepX != 0) map->Prefetch(tileX + stepX, tileY);
+				if(stepY != 0) map->Prefetch(tileX, tileY + stepY);
+				if(stepX != 0 && stepY != 0) map->Prefetch(tileX + stepX, tileY + stepY);
+			}
+
+			for(int i = 0; i < K::Moves::COUNT; i++) {
+				Policy::Move move = K::Moves::MOVES[i];
+				int nextX = (int)x + move.dx;
+				int nextY = (int)y + move.dy;
+				if(!IsOpen(*map, nextX, nextY) || !K::Moves::Allowed(*map, (int)x, (int)y, move)) continue;
+				stats.Generated();
+
+				uint64_t key = (uint64_t)nextX + (uint64_t)nextY * width;
+				Node& next = GetNode(key);
+				if(nodeLimit != 0 && nodeCount > nodeLimit) {
+					limitHit = true;
+					break;
+				}
+				if(next.state == Closed) continue;
+				int newGCost = gCost + K::Cost::Of(move);
+				if(next.state == Open && newGCost >= next.gCost) continue;
+				if(next.state == Open) stats.Updated();
+
+				next.gCost = newGCost;
+				next.move = (uint8_t)i;
+				next.state = Open;
+				int hCost = heuristic(nextX, nextY);
+				open.push_back(OpenEntry{ newGCost + hCost, hCost, key });
+				std::push_heap(open.begin(), open.end(), worse);
+				stats.Pushed(open.size());
+			}
+		}
+		stats.AddTime(&SearchStats::searchNs, phaseStart);
+		if(!reached) {
+			result.stats = stats.Get();
+			return result;
+		}
+
+		// Back from the end along the moves that reached each cell
+		phaseStart = stats.Now();
+		result.found = true;
+		result.cost = GetNode(endKey).gCost;
+		Position pos = end;
+		while(true) {
+			result.path.push_back(pos);
+			uint8_t move = GetNode(pos.x + pos.y * width).move;
+			if(move == NO_MOVE) break;
+			pos.x -= K::Moves::MOVES[move].dx;
+			pos.y -= K::Moves::MOVES[move].dy;
+		}
+		std::reverse(result.path.begin(), result.path.end());
+		stats.AddTime(&SearchStats::pathNs, phaseStart);
+		result.stats = stats.Get();
+		return result;
+	}
+
+	TiledSearch::Node& TiledSearch::GetNode(uint64_t key) {
+		size_t mask = nodes.size() - 1;
+		size_t slot = Hash(key) & mask;
+		while(nodes[slot].key != key) {
+			if(nodes[slot].key == NO_KEY) {
+				// Kept at most half full so probes stay short
+				if((nodeCount + 1) * 2 > nodes.size()) {
+					Grow();
+					return GetNode(key);
+				}
+				nodes[slot].key = key;
+				nodeCount++;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+		return nodes[slot];
+	}
+
+	void TiledSearch::Grow() {
+		std::vector<Node> old(nodes.size() * 2);
+		old.swap(nodes);
+		size_t mask = nodes.size() - 1;
+		for(const Node& node : old) {
+			if(node.key == NO_KEY) continue;
+			size_t slot = Hash(node.key) & mask;
+			while(nodes[slot].key != NO_KEY) slot = (slot + 1) & mask;
+			nodes[slot] = node;
+		}
+	}
+
+	// Indexed by Policy::KernelIndex, unweighted half
+	const std::array<TiledSearch::Kernel, TiledSearch::KERNEL_COUNT> TiledSearch::KERNELS = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<Kernel, sizeof...(I)>{ &TiledSearch::SolveWith<Policy::KernelAt<I>>... };
+	}(std::make_index_sequence<KERNEL_COUNT>{});
+}
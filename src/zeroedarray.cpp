@@ -0,0 +1,38 @@
+#include "zeroedarray.hpp"
+#include <cstdlib>
+#include <new>
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+
+namespace Pathfinding {
+	namespace {
+		// Below this calloc may reuse and clear heap memory, which is cheap at this size
+		const size_t MAPPED_BYTES = 1 << 20;
+	}
+
+	void* AllocateZeroed(size_t bytes) {
+#ifdef __unix__
+		if(bytes >= MAPPED_BYTES) {
+			void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(memory == MAP_FAILED) throw std::bad_alloc();
+			return memory;
+		}
+#endif
+		// Elsewhere calloc, which usually maps big blocks the same way
+		void* memory = calloc(bytes, 1);
+		if(memory == nullptr) throw std::bad_alloc();
+		return memory;
+	}
+
+	void FreeZeroed(void* memory, size_t bytes) {
+		if(memory == nullptr) return;
+#ifdef __unix__
+		if(bytes >= MAPPED_BYTES) {
+			munmap(memory, bytes);
+			return;
+		}
+#endif
+		free(memory);
+	}
+}
@@ -0,0 +1,97 @@
+#include "batch.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// BatchSolver answers against a plain Dijkstra with one and with many threads, and the memory
+// the workers take for short queries on a big map doesn't grow with the thread count.
+//
+//   PathfindingBatchTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	// Resident memory of this process, 0 where /proc isn't there
+	size_t ResidentKB() {
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while(std::getline(status, line)) {
+			if(line.compare(0, 6, "VmRSS:") == 0) return (size_t)atol(line.c_str() + 6);
+		}
+		return 0;
+	}
+
+	int CheckAnswers(uint threads, std::mt19937& random) {
+		const uint size = 64;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 30, random);
+		std::vector<PathQuery> queries;
+		for(int i = 0; i < 300; i++) {
+			queries.push_back(PathQuery{ Reference::RandomFloor(map.grid, random), Reference::RandomFloor(map.grid, random) });
+		}
+
+		BatchSolver solver(map.grid, threads);
+		solver.SetCache(64);
+		// Twice, the second round partly from the cache
+		for(int round = 0; round < 2; round++) {
+			std::vector<PathResult> results = solver.Solve(queries);
+			for(size_t i = 0; i < queries.size(); i++) {
+				const PathQuery& q = queries[i];
+				int expected = Reference::Cost(map.grid, map.grid.Index(q.start.x, q.start.y), map.grid.Index(q.end.x, q.end.y));
+				int cost = results[i].found ? results[i].cost : -1;
+				if(cost != expected || (results[i].found && !Reference::PathOnFloor(map.grid, results[i].path))) {
+					printf("FAIL %u threads: %u,%u -> %u,%u cost %d, expected %d\n", threads, q.start.x, q.start.y, q.end.x,
+					       q.end.y, cost, expected);
+					failures++;
+				}
+			}
+		}
+		return failures;
+	}
+
+	// Memory a solver with the given thread count adds for a batch of short queries
+	size_t SolverMemoryKB(const Grid& grid, uint threads, const std::vector<PathQuery>& queries) {
+		size_t before = ResidentKB();
+		BatchSolver solver(grid, threads);
+		solver.Solve(queries);
+		return ResidentKB() - before;
+	}
+
+	int CheckMemory(std::mt19937& random) {
+		if(ResidentKB() == 0) {
+			printf("No /proc/self/status, memory not checked\n");
+			return 0;
+		}
+		// 64 MB of scratch per worker if it were allocated up front
+		const uint size = 2048;
+		MapData map = Reference::RandomMap(size, size, 10, random);
+		std::vector<PathQuery> queries;
+		for(int i = 0; i < 200; i++) {
+			Position start = { (uint)(random() % (size - 32)), (uint)(random() % (size - 32)) };
+			Position end = { start.x + (uint)(random() % 32), start.y + (uint)(random() % 32) };
+			map.grid.SetWalkable(map.grid.Index(start.x, start.y), true);
+			map.grid.SetWalkable(map.grid.Index(end.x, end.y), true);
+			queries.push_back(PathQuery{ start, end });
+		}
+
+		const uint threads = 16;
+		size_t one = SolverMemoryKB(map.grid, 1, queries);
+		size_t many = SolverMemoryKB(map.grid, threads, queries);
+		// Components labels are the same for both. Every thread may add its stack, allocator arena
+		// and the cells its searches reached, far below the 64 MB of a whole workspace
+		if(many > one + threads * 4 * 1024) {
+			printf("FAIL memory: %zu KB with %u threads, %zu KB with 1\n", many, threads, one);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = CheckAnswers(1, random);
+	failures += CheckAnswers(8, random);
+	failures += CheckMemory(random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,65 @@
+#include "search.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// Bidirectional A* against a plain Dijkstra for every move rule, on terrain and with landmarks.
+// The two halves have to join into one path from start to end that costs what the search says
+// and only makes moves the policy allows.
+//
+//   PathfindingBidirectionalTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	int CheckQueries(const char* name, SearchPolicy policy, bool terrain, uint landmarkCount, std::mt19937& random) {
+		const uint size = 48;
+		const int queries = 150;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 25, random);
+		if(terrain) Reference::AddTerrain(map, 4, random);
+		const TerrainCosts* costs = terrain ? &map.costs : nullptr;
+		Landmarks landmarks;
+		landmarks.Build(map.grid, landmarkCount, 1);
+
+		Search search;
+		search.SetGrid(&map.grid);
+		search.SetPolicy(policy);
+		search.SetCosts(costs);
+		search.SetLandmarks(&landmarks);
+		search.SetAlgorithm(Bidirectional);
+		for(int i = 0; i < queries && failures < 10; i++) {
+			Position start = Reference::RandomFloor(map.grid, random);
+			Position end = Reference::RandomFloor(map.grid, random);
+			CellIndex startCell = map.grid.Index(start.x, start.y);
+			CellIndex endCell = map.grid.Index(end.x, end.y);
+
+			PathResult result = search.Solve(startCell, endCell);
+			int expected = Reference::Cost(map.grid, startCell, endCell, policy, costs);
+			int cost = result.found ? result.cost : -1;
+			bool valid = !result.found
+			             || (result.path.front() == start && result.path.back() == end
+			                 && Reference::PathCost(map.grid, result.path, policy, costs) == cost);
+			if(cost != expected || !valid) {
+				printf("FAIL %s: %u,%u -> %u,%u cost %d, expected %d%s\n", name, start.x, start.y, end.x, end.y, cost, expected,
+				       valid ? "" : ", path doesn't match");
+				failures++;
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	SearchPolicy noCorners{ EightWayNoCorners, OctileCost, Octile };
+	SearchPolicy fourWay{ FourWay, OctileCost, Manhattan };
+	SearchPolicy uniform{ EightWay, UniformCost, Chebyshev };
+	int failures = CheckQueries("8-way", SearchPolicy(), false, 0, random);
+	failures += CheckQueries("no corners", noCorners, false, 0, random);
+	failures += CheckQueries("4-way", fourWay, false, 0, random);
+	failures += CheckQueries("uniform cost", uniform, false, 0, random);
+	failures += CheckQueries("terrain", SearchPolicy(), true, 0, random);
+	failures += CheckQueries("landmarks", SearchPolicy(), false, 4, random);
+	failures += CheckQueries("landmarks terrain", SearchPolicy(), true, 4, random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,98 @@
+#include "bucketqueue.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+#include <set>
+#include <utility>
+
+// BucketQueue against an ordered set of (fCost, cell) while the keys climb far past the window,
+// so buckets are reused for keys a whole window apart, and now and then jump far enough to grow it.
+// Cells come back after being popped, like reopened ones, with keys their outdated entries had.
+// Equal keys may pop in either order, only the key is compared
+//
+//   PathfindingBucketQueueTest [seed]
+
+using namespace Pathfinding;
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	const size_t cellCount = 512;
+	int failures = 0;
+
+	BucketQueue queue;
+	queue.Resize(cellCount);
+	typedef std::pair<int, CellIndex> Key;
+	std::set<Key> expected;
+	std::vector<int> keyOf(cellCount, 0);
+	std::vector<int> outdatedKey(cellCount, -1); // Key of the cell's latest outdated entry
+	std::vector<bool> inSet(cellCount, false);
+	auto fail = [&](const char* what, int round) {
+		printf("FAIL %s in round %d\n", what, round);
+		failures++;
+	};
+
+	// Keys stay above the lowest queued one, like fCosts in a search
+	int floor = 0;
+	for(int round = 0; round < 300000 && failures < 10; round++) {
+		CellIndex cell = (CellIndex)(random() % cellCount);
+		// Mostly close together, sometimes far enough apart to grow the window
+		int spread = random() % 1000 == 0 ? 5000 : 40;
+		int fCost = floor + (int)(random() % spread);
+		uint operation = random() % 6;
+
+		if(queue.Contains(cell) != inSet[cell]) fail("membership", round);
+
+		if(operation < 2 && !inSet[cell]) {
+			queue.Push(cell, fCost, 0);
+			keyOf[cell] = fCost;
+			expected.insert(Key(fCost, cell));
+			inSet[cell] = true;
+		}
+		else if(operation < 4 && !expected.empty()) {
+			Key lowest = *expected.begin();
+			if(queue.TopFCost() != lowest.first) fail("top key", round);
+			CellIndex popped = queue.Pop();
+			if(!inSet[popped] || keyOf[popped] != lowest.first) {
+				fail("pop order", round);
+				continue;
+			}
+			expected.erase(Key(keyOf[popped], popped));
+			inSet[popped] = false;
+			floor = lowest.first;
+		}
+		else if(operation == 4 && inSet[cell] && keyOf[cell] > floor) {
+			// Lower key only, leaves an outdated entry behind
+			int lower = std::max(floor, keyOf[cell] - 1 - (int)(random() % 20));
+			queue.DecreaseKey(cell, lower, 0);
+			outdatedKey[cell] = keyOf[cell];
+			expected.erase(Key(keyOf[cell], cell));
+			keyOf[cell] = lower;
+			expected.insert(Key(lower, cell));
+		}
+		else if(operation == 5 && !inSet[cell] && outdatedKey[cell] >= floor) {
+			// Back with the key of an entry it left behind, which may still be queued
+			keyOf[cell] = outdatedKey[cell];
+			queue.Push(cell, keyOf[cell], 0);
+			expected.insert(Key(keyOf[cell], cell));
+			inSet[cell] = true;
+		}
+
+		if(queue.Size() != expected.size()) fail("size", round);
+		if(round % 100000 == 99999) {
+			queue.Clear();
+			expected.clear();
+			inSet.assign(cellCount, false);
+			if(!queue.Empty()) fail("clear", round);
+		}
+	}
+
+	// Draining gives every key in order
+	while(!queue.Empty() && failures < 10) {
+		Key lowest = *expected.begin();
+		CellIndex popped = queue.Pop();
+		if(!inSet[popped] || keyOf[popped] != lowest.first) fail("drain order", -1);
+		expected.erase(Key(keyOf[popped], popped));
+		inSet[popped] = false;
+	}
+	if(!expected.empty()) fail("drain size", -1);
+	return Reference::Finish(failures);
+}
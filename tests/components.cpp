@@ -0,0 +1,89 @@
+#include "components.hpp"
+#include "search.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// Components labels kept up to date through random wall edits, 8-connected and 4-connected,
+// against reachability from a plain Dijkstra with the matching moves. A search that cuts corners
+// has to ignore 4-connected labels instead of dropping queries across diagonal gaps.
+//
+//   PathfindingComponentsTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	int CheckEdits(const char* name, bool diagonal, std::mt19937& random) {
+		const uint size = 40;
+		const int rounds = 40;
+		const int edits = 25;
+		int failures = 0;
+		SearchPolicy policy{ diagonal ? EightWay : FourWay, OctileCost, diagonal ? Octile : Manhattan };
+		MapData map = Reference::RandomMap(size, size, 40, random);
+		Components components;
+		components.Build(map.grid, diagonal);
+
+		for(int round = 0; round < rounds && failures < 10; round++) {
+			for(int i = 0; i < edits; i++) {
+				CellIndex cell = (CellIndex)(random() % map.grid.CellCount());
+				bool walkable = !map.grid.IsWalkable(cell);
+				map.grid.SetWalkable(cell, walkable);
+				components.SetWalkable(map.grid, cell, walkable);
+			}
+			// Every cell against one start, walls have no component
+			Position start = Reference::RandomFloor(map.grid, random);
+			CellIndex startCell = map.grid.Index(start.x, start.y);
+			std::vector<int> costs = Reference::CostsFrom(map.grid, startCell, policy);
+			for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+				bool expected = costs[cell] >= 0;
+				if(components.Connected(startCell, cell) != expected) {
+					Position pos = map.grid.ToPosition(cell);
+					printf("FAIL %s: %u,%u and %u,%u connected %d, expected %d in round %d\n", name, start.x, start.y, pos.x,
+					       pos.y, !expected, expected, round);
+					failures++;
+				}
+				if(!map.grid.IsWalkable(cell) && components.Get(cell) != Components::NO_COMPONENT) {
+					printf("FAIL %s: wall %u has a component\n", name, cell);
+					failures++;
+				}
+			}
+		}
+		return failures;
+	}
+
+	// Two rooms touching only at a corner: 4-connected labels tell them apart,
+	// but a search cutting corners still walks through
+	int CheckDiagonalGap(std::mt19937& random) {
+		MapData map = Reference::RandomMap(4, 4, 0, random);
+		int failures = 0;
+		for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+			Position pos = map.grid.ToPosition(cell);
+			map.grid.SetWalkable(cell, (pos.x < 2) == (pos.y < 2));
+		}
+		Components components;
+		components.Build(map.grid, false);
+		CellIndex start = map.grid.Index(0, 0);
+		CellIndex end = map.grid.Index(3, 3);
+
+		Search search;
+		search.SetGrid(&map.grid);
+		search.SetComponents(&components);
+		for(Connectivity connectivity : { EightWay, EightWayNoCorners, FourWay }) {
+			search.SetPolicy(SearchPolicy{ connectivity, OctileCost, connectivity == FourWay ? Manhattan : Octile });
+			PathResult result = search.Solve(start, end);
+			bool expected = connectivity == EightWay;
+			if(result.found != expected) {
+				printf("FAIL diagonal gap: connectivity %d found %d, expected %d\n", connectivity, result.found, expected);
+				failures++;
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = CheckDiagonalGap(random);
+	failures += CheckEdits("8-connected", true, random);
+	failures += CheckEdits("4-connected", false, random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,72 @@
+#include "dstarlite.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// D* Lite replanning against a plain Dijkstra. The start walks along the path while walls open
+// and close around it, every replan has to give the best path over the edited grid, the same
+// cost a search from scratch finds.
+//
+//   PathfindingDStarLiteTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	int CheckReplanning(uint wallPercent, std::mt19937& random) {
+		const uint size = 40;
+		const int moves = 60;
+		const int edits = 6;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, wallPercent, random);
+		Position start = Reference::RandomFloor(map.grid, random);
+		Position end = Reference::RandomFloor(map.grid, random);
+		CellIndex startCell = map.grid.Index(start.x, start.y);
+		CellIndex endCell = map.grid.Index(end.x, end.y);
+
+		DStarLite dstar;
+		dstar.SetGrid(&map.grid);
+		dstar.Begin(startCell, endCell);
+		for(int move = 0; move < moves && failures < 10; move++) {
+			dstar.Run();
+			PathResult result = dstar.GetPath();
+			int expected = Reference::Cost(map.grid, startCell, endCell);
+			int cost = result.found ? result.cost : -1;
+			bool valid = !result.found
+			             || (result.path.front() == map.grid.ToPosition(startCell) && result.path.back() == end
+			                 && Reference::PathOnFloor(map.grid, result.path));
+			if(cost != expected || !valid) {
+				Position from = map.grid.ToPosition(startCell);
+				printf("FAIL %u%% walls, move %d: %u,%u -> %u,%u cost %d, expected %d%s\n", wallPercent, move, from.x, from.y,
+				       end.x, end.y, cost, expected, valid ? "" : ", path doesn't match");
+				failures++;
+			}
+
+			// One step along the path, or a jump elsewhere when there is none
+			if(result.found && result.path.size() > 2) {
+				startCell = map.grid.Index(result.path[1].x, result.path[1].y);
+			}
+			else {
+				Position next = Reference::RandomFloor(map.grid, random);
+				startCell = map.grid.Index(next.x, next.y);
+			}
+			dstar.MoveStart(startCell);
+
+			for(int i = 0; i < edits; i++) {
+				CellIndex cell = (CellIndex)(random() % map.grid.CellCount());
+				if(cell == startCell || cell == endCell) continue;
+				dstar.SetWalkable(cell, !map.grid.IsWalkable(cell));
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = 0;
+	for(uint wallPercent : { 0u, 20u, 35u }) {
+		for(int map = 0; map < 4; map++) {
+			failures += CheckReplanning(wallPercent, random);
+		}
+	}
+	return Reference::Finish(failures);
+}
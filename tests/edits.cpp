@@ -0,0 +1,94 @@
+#include "pathfinding.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// Regression check for wall edits made while one algorithm is active and queries run later with another.
+// Every Pathfinder answer is compared with a plain Dijkstra over the edited grid, and so are the
+// landmark tables lowered in place.
+//
+//   PathfindingEditsTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	// Selects `before`, switches to Incremental, edits walls, switches back and checks FindPath
+	int CheckEdits(const char* name, Algorithm before, uint landmarks, std::mt19937& random) {
+		const uint size = 48;
+		const int rounds = 8;
+		const int edits = 30;
+		const int queries = 40;
+		int failures = 0;
+		for(int round = 0; round < rounds; round++) {
+			MapData map = Reference::RandomMap(size, size, 30, random);
+			Pathfinder pathfinder;
+			pathfinder.SetCacheCapacity(0);
+			pathfinder.SetData(map);
+			pathfinder.SetLandmarks(landmarks);
+			pathfinder.SetAlgorithm(before);
+			pathfinder.FindPath(Position{ 0, 0 }, Position{ size - 1, size - 1 });
+
+			pathfinder.SetAlgorithm(Incremental);
+			for(int i = 0; i < edits; i++) {
+				uint x = random() % size;
+				uint y = random() % size;
+				pathfinder.SetWalkable(x, y, !pathfinder.GetGrid().IsWalkable(x, y));
+			}
+			pathfinder.SetAlgorithm(before);
+
+			const Grid& grid = pathfinder.GetGrid();
+			for(int i = 0; i < queries; i++) {
+				Position start = { (uint)(random() % size), (uint)(random() % size) };
+				Position end = { (uint)(random() % size), (uint)(random() % size) };
+				if(!grid.IsWalkable(start.x, start.y) || !grid.IsWalkable(end.x, end.y)) continue;
+				PathResult result = pathfinder.FindPath(start, end);
+				int expected = Reference::Cost(grid, grid.Index(start.x, start.y), grid.Index(end.x, end.y));
+				int cost = result.found ? result.cost : -1;
+				if(cost != expected || (result.found && !Reference::PathOnFloor(grid, result.path))) {
+					printf("FAIL %s: %u,%u -> %u,%u cost %d, expected %d\n", name, start.x, start.y, end.x, end.y, cost, expected);
+					failures++;
+				}
+			}
+		}
+		return failures;
+	}
+
+	// Tables lowered in place after walls are removed against fresh costs from every landmark.
+	// A landmark's bound to a cell is its exact cost from there
+	int CheckLandmarkTables(std::mt19937& random) {
+		const uint size = 48;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 40, random);
+		Landmarks landmarks;
+		landmarks.Build(map.grid, 4, 1);
+		for(int i = 0; i < 60; i++) {
+			CellIndex cell = (CellIndex)(random() % map.grid.CellCount());
+			if(map.grid.IsWalkable(cell)) continue;
+			map.grid.SetWalkable(cell, true);
+			if(!landmarks.Open(map.grid, cell)) {
+				printf("FAIL landmark tables: exact tables not lowered in place\n");
+				return failures + 1;
+			}
+		}
+		for(uint i = 0; i < landmarks.Count(); i++) {
+			CellIndex landmark = landmarks.GetLandmark(i);
+			std::vector<int> expected = Reference::CostsFrom(map.grid, landmark);
+			for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+				int bound = landmarks.LowerBound(landmark, cell);
+				if(expected[cell] >= 0 && bound != expected[cell]) {
+					Position pos = map.grid.ToPosition(cell);
+					printf("FAIL landmark tables: landmark %u to %u,%u bound %d, expected %d\n", i, pos.x, pos.y, bound, expected[cell]);
+					failures++;
+				}
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = CheckLandmarkTables(random);
+	failures += CheckEdits("jps+ after incremental edits", JumpPointSearchPlus, 0, random);
+	failures += CheckEdits("landmarks after incremental edits", AStar, 4, random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,76 @@
+#include "flowfield.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// Flow field distances against a plain Dijkstra from the goal, built on one thread and on several.
+// Every cell's direction has to lead one move closer, and paths read from the field end at the
+// goal costing what the distances say.
+//
+//   PathfindingFlowFieldTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	int CheckField(const char* name, uint size, uint threads, std::mt19937& random) {
+		const int paths = 50;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 30, random);
+		Position goal = Reference::RandomFloor(map.grid, random);
+		CellIndex goalCell = map.grid.Index(goal.x, goal.y);
+		FlowField field;
+		field.Build(map.grid, goalCell, threads);
+
+		std::vector<int> expected = Reference::CostsFrom(map.grid, goalCell);
+		for(CellIndex cell = 0; cell < map.grid.CellCount() && failures < 10; cell++) {
+			uint32_t distance = field.GetDistance(cell);
+			int cost = distance == FlowField::UNREACHABLE ? -1 : (int)distance;
+			Position pos = map.grid.ToPosition(cell);
+			if(cost != expected[cell]) {
+				printf("FAIL %s: %u,%u distance %d, expected %d\n", name, pos.x, pos.y, cost, expected[cell]);
+				failures++;
+				continue;
+			}
+			// One move towards the goal, down by exactly its cost
+			CellIndex next = field.Next(cell);
+			if(cost <= 0) {
+				if(next != INVALID_CELL) {
+					printf("FAIL %s: %u,%u points somewhere without a path\n", name, pos.x, pos.y);
+					failures++;
+				}
+				continue;
+			}
+			Position to = next == INVALID_CELL ? pos : map.grid.ToPosition(next);
+			int dx = abs((int)to.x - (int)pos.x);
+			int dy = abs((int)to.y - (int)pos.y);
+			int move = dx + dy == 2 ? 14 : 10;
+			if(next == INVALID_CELL || dx > 1 || dy > 1 || expected[next] != cost - move) {
+				printf("FAIL %s: %u,%u points to %u,%u, not one move closer\n", name, pos.x, pos.y, to.x, to.y);
+				failures++;
+			}
+		}
+
+		for(int i = 0; i < paths; i++) {
+			Position start = Reference::RandomFloor(map.grid, random);
+			CellIndex startCell = map.grid.Index(start.x, start.y);
+			PathResult result = field.GetPath(startCell);
+			int cost = result.found ? result.cost : -1;
+			bool valid = !result.found
+			             || (result.path.front() == start && result.path.back() == goal && Reference::PathOnFloor(map.grid, result.path));
+			if(cost != expected[startCell] || !valid) {
+				printf("FAIL %s: path %u,%u -> %u,%u cost %d, expected %d%s\n", name, start.x, start.y, goal.x, goal.y, cost,
+				       expected[startCell], valid ? "" : ", path doesn't match");
+				failures++;
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = CheckField("small", 40, 1, random);
+	// Big enough to split the buckets between threads
+	failures += CheckField("one thread", 300, 1, random);
+	failures += CheckField("four threads", 300, 4, random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,96 @@
+#include "hierarchical.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// HPA* paths against a plain Dijkstra. Paths may cost more than the best ones, but never less,
+// they have to walk the floor and cost what they say. On open ground, ends in the same or touching
+// clusters always get the best path, HPA* once took seven times as long for cells side by side
+// across a cluster border.
+//
+//   PathfindingHierarchicalTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	const uint CLUSTER_SIZE = 16;
+
+	// What the path costs with 8-way octile moves, -1 if it isn't a chain of moves on the floor
+	int PathCost(const Grid& grid, const std::vector<Position>& path) {
+		int cost = 0;
+		for(size_t i = 0; i < path.size(); i++) {
+			if(!grid.IsWalkable(path[i].x, path[i].y)) return -1;
+			if(i == 0) continue;
+			int dx = abs((int)path[i].x - (int)path[i - 1].x);
+			int dy = abs((int)path[i].y - (int)path[i - 1].y);
+			if(dx > 1 || dy > 1 || dx + dy == 0) return -1;
+			cost += dx + dy == 2 ? 14 : 10;
+		}
+		return cost;
+	}
+
+	// Queries whose ends are at most one cluster apart when near is set
+	Position Other(const Grid& grid, Position start, bool near, std::mt19937& random) {
+		while(true) {
+			Position end = Reference::RandomFloor(grid, random);
+			if(!near) return end;
+			int dx = (int)(end.x / CLUSTER_SIZE) - (int)(start.x / CLUSTER_SIZE);
+			int dy = (int)(end.y / CLUSTER_SIZE) - (int)(start.y / CLUSTER_SIZE);
+			if(abs(dx) <= 1 && abs(dy) <= 1) return end;
+		}
+	}
+
+	int CheckQueries(const char* name, uint wallPercent, bool near, std::mt19937& random) {
+		const uint size = 80;
+		const int queries = 300;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, wallPercent, random);
+		ClusterGraph graph;
+		graph.Build(map.grid, CLUSTER_SIZE);
+		HierarchicalPathfinder pathfinder(graph);
+
+		for(int i = 0; i < queries; i++) {
+			Position start = Reference::RandomFloor(map.grid, random);
+			Position end = Other(map.grid, start, near, random);
+			CellIndex startCell = map.grid.Index(start.x, start.y);
+			CellIndex endCell = map.grid.Index(end.x, end.y);
+			PathResult result = pathfinder.Solve(startCell, endCell);
+
+			int expected = Reference::Cost(map.grid, startCell, endCell);
+			int cost = result.found ? result.cost : -1;
+			bool valid = !result.found
+			             || (result.path.front() == start && result.path.back() == end && PathCost(map.grid, result.path) == cost);
+			// Exact on open ground, never below the best cost and found whenever a path exists
+			bool acceptable = wallPercent == 0 ? cost == expected : (expected < 0 ? cost < 0 : cost >= expected);
+			if(!valid || !acceptable) {
+				printf("FAIL %s: %u,%u -> %u,%u cost %d, expected %d%s\n", name, start.x, start.y, end.x, end.y, cost, expected,
+				       valid ? "" : ", path doesn't match");
+				failures++;
+			}
+		}
+		return failures;
+	}
+
+	// Side by side across a cluster border, halfway between the entrances at the ends of the border
+	int CheckAcrossBorder(std::mt19937& random) {
+		MapData map = Reference::RandomMap(64, 64, 0, random);
+		ClusterGraph graph;
+		graph.Build(map.grid, CLUSTER_SIZE);
+		HierarchicalPathfinder pathfinder(graph);
+		PathResult result = pathfinder.Solve(map.grid.Index(15, 7), map.grid.Index(16, 7));
+		if(!result.found || result.cost != 10) {
+			printf("FAIL across border: cost %d, expected 10\n", result.found ? result.cost : -1);
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = CheckAcrossBorder(random);
+	failures += CheckQueries("open near", 0, true, random);
+	failures += CheckQueries("random near", 20, true, random);
+	failures += CheckQueries("random far", 20, false, random);
+	failures += CheckQueries("dense far", 40, false, random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,102 @@
+#include "openset.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+#include <set>
+#include <tuple>
+
+// OpenSet against an ordered set of (fCost, hCost, cell) under random pushes, pops,
+// decrease-keys, updates and removals. Equal keys may pop in either order, only the key is compared
+//
+//   PathfindingOpenSetTest [seed]
+
+using namespace Pathfinding;
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	const size_t cellCount = 512;
+	int failures = 0;
+
+	OpenSet open;
+	open.Resize(cellCount);
+	typedef std::tuple<int, int, CellIndex> Key;
+	std::set<Key> expected;
+	std::vector<Key> keyOf(cellCount);
+	std::vector<bool> inSet(cellCount, false);
+	auto fail = [&](const char* what, int round) {
+		printf("FAIL %s in round %d\n", what, round);
+		failures++;
+	};
+
+	for(int round = 0; round < 200000 && failures < 10; round++) {
+		CellIndex cell = (CellIndex)(random() % cellCount);
+		int fCost = (int)(random() % 200);
+		int hCost = (int)(random() % 20);
+		uint operation = random() % 8;
+
+		if(open.Contains(cell) != inSet[cell]) fail("membership", round);
+		bool queued = inSet[cell];
+
+		if(operation < 3 && !queued) {
+			open.Push(cell, fCost, hCost);
+			keyOf[cell] = Key(fCost, hCost, cell);
+			expected.insert(keyOf[cell]);
+			inSet[cell] = true;
+		}
+		else if(operation < 5 && !expected.empty()) {
+			Key lowest = *expected.begin();
+			if(open.TopFCost() != std::get<0>(lowest) || open.TopHCost() != std::get<1>(lowest)) fail("top key", round);
+			CellIndex popped = open.Pop();
+			Key poppedKey = keyOf[popped];
+			if(std::get<0>(poppedKey) != std::get<0>(lowest) || std::get<1>(poppedKey) != std::get<1>(lowest)
+			   || expected.erase(poppedKey) != 1) {
+				fail("pop order", round);
+			}
+			inSet[popped] = false;
+		}
+		else if(operation == 5 && queued) {
+			// Lower or equal key only
+			Key old = keyOf[cell];
+			int lowerF = std::get<0>(old) - (int)(random() % 10);
+			open.DecreaseKey(cell, lowerF, std::get<1>(old));
+			expected.erase(old);
+			keyOf[cell] = Key(lowerF, std::get<1>(old), cell);
+			expected.insert(keyOf[cell]);
+		}
+		else if(operation == 6 && queued) {
+			open.Update(cell, fCost, hCost);
+			expected.erase(keyOf[cell]);
+			keyOf[cell] = Key(fCost, hCost, cell);
+			expected.insert(keyOf[cell]);
+		}
+		else if(operation == 7 && queued) {
+			open.Remove(cell);
+			expected.erase(keyOf[cell]);
+			inSet[cell] = false;
+		}
+
+		if(open.Size() != expected.size()) fail("size", round);
+		if(round % 50000 == 49999) {
+			open.Clear();
+			expected.clear();
+			inSet.assign(cellCount, false);
+			if(!open.Empty()) fail("clear", round);
+		}
+	}
+
+	// Draining gives every key in order
+	for(int i = 0; i < 300; i++) {
+		CellIndex cell = (CellIndex)(random() % cellCount);
+		if(open.Contains(cell)) continue;
+		keyOf[cell] = Key((int)(random() % 50), (int)(random() % 5), cell);
+		open.Push(cell, std::get<0>(keyOf[cell]), std::get<1>(keyOf[cell]));
+		expected.insert(keyOf[cell]);
+		inSet[cell] = true;
+	}
+	while(!open.Empty()) {
+		Key lowest = *expected.begin();
+		Key popped = keyOf[open.Pop()];
+		if(std::get<0>(popped) != std::get<0>(lowest) || std::get<1>(popped) != std::get<1>(lowest)) fail("drain order", -1);
+		expected.erase(popped);
+	}
+	return Reference::Finish(failures);
+}
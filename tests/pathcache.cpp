@@ -0,0 +1,117 @@
+#include "pathcache.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// PathCache answers against a plain Dijkstra while walls open and close between queries.
+// Cached paths and slices of them have to stay optimal over the edited grid, for every move rule
+// and on terrain, and a path found before an edit must not be stored after it.
+//
+//   PathfindingPathCacheTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	void Edit(MapData& map, PathCache& cache, CellIndex cell) {
+		bool walkable = !map.grid.IsWalkable(cell);
+		map.grid.SetWalkable(cell, walkable);
+		// Opened walls become plain floor
+		if(walkable && !map.costs.Empty() && map.costs.Get(cell) == 0) map.costs.Set(cell, 1);
+		cache.SetWalkable(cell, walkable);
+	}
+
+	int CheckEdits(const char* name, SearchPolicy policy, bool terrain, std::mt19937& random) {
+		const uint size = 32;
+		const int rounds = 40;
+		const int queries = 60;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 20, random);
+		if(terrain) Reference::AddTerrain(map, 3, random);
+		const TerrainCosts* costs = terrain ? &map.costs : nullptr;
+
+		Search search;
+		search.SetGrid(&map.grid);
+		search.SetPolicy(policy);
+		search.SetCosts(costs);
+		PathCache cache(64);
+		cache.SetGrid(&map.grid);
+		cache.SetPolicy(policy);
+		cache.SetCosts(costs);
+
+		// Few ends, so later queries often lie on cached paths
+		std::vector<Position> ends;
+		for(int i = 0; i < 6; i++) ends.push_back(Reference::RandomFloor(map.grid, random));
+		for(int round = 0; round < rounds && failures < 10; round++) {
+			for(int i = 0; i < queries; i++) {
+				Position start = Reference::RandomFloor(map.grid, random);
+				Position end = ends[random() % ends.size()];
+				CellIndex startCell = map.grid.Index(start.x, start.y);
+				CellIndex endCell = map.grid.Index(end.x, end.y);
+				if(!map.grid.IsWalkable(endCell)) continue;
+
+				PathResult result;
+				bool cached = cache.Lookup(startCell, endCell, result);
+				if(!cached) {
+					uint64_t version = cache.Version();
+					result = search.Solve(startCell, endCell);
+					cache.Store(startCell, endCell, version, result);
+				}
+				int expected = Reference::Cost(map.grid, startCell, endCell, policy, costs);
+				int cost = result.found ? result.cost : -1;
+				bool valid = !result.found
+				             || (result.path.front() == start && result.path.back() == end
+				                 && Reference::PathCost(map.grid, result.path, policy, costs) == cost);
+				if(cost != expected || !valid) {
+					printf("FAIL %s: %u,%u -> %u,%u %s cost %d, expected %d%s\n", name, start.x, start.y, end.x, end.y,
+					       cached ? "cached" : "searched", cost, expected, valid ? "" : ", path doesn't match");
+					failures++;
+				}
+			}
+			for(int i = 0; i < 8; i++) {
+				Edit(map, cache, (CellIndex)(random() % map.grid.CellCount()));
+			}
+		}
+		if(cache.Hits() == 0) {
+			printf("FAIL %s: no query answered from the cache\n", name);
+			failures++;
+		}
+		return failures;
+	}
+
+	// A wall put across the only way while the search ran, its path belongs to the old map
+	int CheckStaleStore(std::mt19937& random) {
+		MapData map = Reference::RandomMap(9, 3, 0, random);
+		for(uint x = 0; x < 9; x++) {
+			map.grid.SetWalkable(map.grid.Index(x, 0), false);
+			map.grid.SetWalkable(map.grid.Index(x, 2), false);
+		}
+		Search search;
+		search.SetGrid(&map.grid);
+		PathCache cache(64);
+		cache.SetGrid(&map.grid);
+		CellIndex start = map.grid.Index(0, 1);
+		CellIndex end = map.grid.Index(8, 1);
+
+		uint64_t version = cache.Version();
+		PathResult result = search.Solve(start, end);
+		Edit(map, cache, map.grid.Index(4, 1));
+		cache.Store(start, end, version, result);
+		PathResult cached;
+		if(cache.Lookup(start, end, cached) || cache.Lookup(map.grid.Index(1, 1), map.grid.Index(7, 1), cached)) {
+			printf("FAIL stale store: path found before the edit was cached\n");
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	SearchPolicy noCorners{ EightWayNoCorners, OctileCost, Octile };
+	SearchPolicy fourWay{ FourWay, OctileCost, Manhattan };
+	int failures = CheckStaleStore(random);
+	failures += CheckEdits("8-way", SearchPolicy(), false, random);
+	failures += CheckEdits("no corners", noCorners, false, random);
+	failures += CheckEdits("4-way", fourWay, false, random);
+	failures += CheckEdits("terrain", SearchPolicy(), true, random);
+	return Reference::Finish(failures);
+}
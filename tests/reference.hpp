@@ -0,0 +1,148 @@
+#pragma once
+#include <climits>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+#include "grid.hpp"
+#include "mapio.hpp"
+#include "policies.hpp"
+#include "terrain.hpp"
+
+// Shared by the regression checks: small random maps and a plain Dijkstra to compare answers with.
+// Each check is its own executable that prints every failure and exits with 1 if there were any
+
+namespace Pathfinding {
+	namespace Reference {
+		inline int Sign(int value) {
+			return (value > 0) - (value < 0);
+		}
+
+		// Start is the first cell and end the last, both kept open
+		inline MapData RandomMap(uint width, uint height, uint wallPercent, std::mt19937& random) {
+			MapData map;
+			map.grid.Resize(width, height);
+			for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+				map.grid.SetWalkable(cell, random() % 100 >= wallPercent);
+			}
+			map.start = 0;
+			map.end = (CellIndex)map.grid.CellCount() - 1;
+			map.grid.SetWalkable(map.start, true);
+			map.grid.SetWalkable(map.end, true);
+			return map;
+		}
+
+		// Terrain of 1 to maxCost on every open cell
+		inline void AddTerrain(MapData& map, uint maxCost, std::mt19937& random) {
+			map.costs.Resize(map.grid.CellCount());
+			for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+				map.costs.Set(cell, map.grid.IsWalkable(cell) ? (uint8_t)(1 + random() % maxCost) : 0);
+			}
+		}
+
+		inline Position RandomFloor(const Grid& grid, std::mt19937& random) {
+			while(true) {
+				Position pos = { (uint)(random() % grid.Width()), (uint)(random() % grid.Height()) };
+				if(grid.IsWalkable(pos.x, pos.y)) return pos;
+			}
+		}
+
+		// Cheapest cost from start to every cell with the policy's moves and costs, -1 where unreachable.
+		// Entering a cell costs the move times its terrain cost, like the searches
+		inline std::vector<int> CostsFrom(const Grid& grid, CellIndex start, SearchPolicy policy = SearchPolicy(),
+		                                  const TerrainCosts* costs = nullptr) {
+			std::vector<int> cost(grid.CellCount(), INT_MAX);
+			typedef std::pair<int, CellIndex> Entry;
+			std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+			cost[start] = 0;
+			open.push({ 0, start });
+			while(!open.empty()) {
+				auto [current, cell] = open.top();
+				open.pop();
+				if(current != cost[cell]) continue;
+				Position pos = grid.ToPosition(cell);
+				for(int dy = -1; dy <= 1; dy++) {
+					for(int dx = -1; dx <= 1; dx++) {
+						if(dx == 0 && dy == 0) continue;
+						bool diagonal = dx != 0 && dy != 0;
+						if(diagonal && policy.connectivity == FourWay) continue;
+						int x = (int)pos.x + dx;
+						int y = (int)pos.y + dy;
+						if(!IsOpen(grid, x, y)) continue;
+						if(diagonal && policy.connectivity == EightWayNoCorners
+						   && (!IsOpen(grid, x, (int)pos.y) || !IsOpen(grid, (int)pos.x, y))) continue;
+
+						CellIndex next = grid.Index(x, y);
+						int move = diagonal && policy.cost == OctileCost ? 14 : 10;
+						if(costs != nullptr && !costs->Empty()) move *= costs->Get(next);
+						if(current + move < cost[next]) {
+							cost[next] = current + move;
+							open.push({ cost[next], next });
+						}
+					}
+				}
+			}
+			for(int& value : cost) {
+				if(value == INT_MAX) value = -1;
+			}
+			return cost;
+		}
+
+		inline int Cost(const Grid& grid, CellIndex start, CellIndex end, SearchPolicy policy = SearchPolicy(),
+		                const TerrainCosts* costs = nullptr) {
+			return CostsFrom(grid, start, policy, costs)[end];
+		}
+
+		// What walking the path one move at a time costs with the policy's moves and costs,
+		// -1 when it leaves the floor or makes a move the policy doesn't allow
+		inline int PathCost(const Grid& grid, const std::vector<Position>& path, SearchPolicy policy = SearchPolicy(),
+		                    const TerrainCosts* costs = nullptr) {
+			int total = 0;
+			for(size_t i = 0; i < path.size(); i++) {
+				if(!grid.IsWalkable(path[i].x, path[i].y)) return -1;
+				if(i == 0) continue;
+				int dx = (int)path[i].x - (int)path[i - 1].x;
+				int dy = (int)path[i].y - (int)path[i - 1].y;
+				bool diagonal = dx != 0 && dy != 0;
+				if(abs(dx) > 1 || abs(dy) > 1 || (dx == 0 && dy == 0)) return -1;
+				if(diagonal && policy.connectivity == FourWay) return -1;
+				if(diagonal && policy.connectivity == EightWayNoCorners
+				   && (!IsOpen(grid, (int)path[i].x, (int)path[i - 1].y) || !IsOpen(grid, (int)path[i - 1].x, (int)path[i].y))) {
+					return -1;
+				}
+				int move = diagonal && policy.cost == OctileCost ? 14 : 10;
+				if(costs != nullptr && !costs->Empty()) move *= costs->Get(grid.Index(path[i].x, path[i].y));
+				total += move;
+			}
+			return total;
+		}
+
+		// Jump point paths only list turns, walks the straight runs between them too
+		inline bool PathOnFloor(const Grid& grid, const std::vector<Position>& path) {
+			for(size_t i = 0; i < path.size(); i++) {
+				Position pos = path[i];
+				if(!grid.IsWalkable(pos.x, pos.y)) return false;
+				if(i + 1 == path.size()) break;
+				int stepX = Sign((int)path[i + 1].x - (int)pos.x);
+				int stepY = Sign((int)path[i + 1].y - (int)pos.y);
+				while(pos.x != path[i + 1].x || pos.y != path[i + 1].y) {
+					pos.x += stepX;
+					pos.y += stepY;
+					if(!grid.IsWalkable(pos.x, pos.y)) return false;
+				}
+			}
+			return true;
+		}
+
+		inline int Finish(int failures) {
+			if(failures > 0) {
+				printf("%d failures\n", failures);
+				return 1;
+			}
+			printf("OK\n");
+			return 0;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#include "search.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// One Search answering many queries in a row, so every query runs on scratch memory left
+// over from the ones before it. Costs are compared with a plain Dijkstra for every mode, move rule
+// and terrain, and nothing an earlier search reached may show through a new one.
+//
+//   PathfindingSearchSpaceTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	// Stamps of older searches read as Unvisited, the current one's as set
+	int CheckStamps(std::mt19937& random) {
+		const size_t cellCount = 300;
+		int failures = 0;
+		SearchSpace space;
+		space.Resize(cellCount);
+		std::vector<NodeState> expected(cellCount, Unvisited);
+		for(int search = 0; search < 2000; search++) {
+			space.Reset();
+			expected.assign(cellCount, Unvisited);
+			for(int i = 0; i < 100; i++) {
+				CellIndex cell = (CellIndex)(random() % cellCount);
+				NodeState state = random() % 2 == 0 ? Open : Closed;
+				space.SetState(cell, state);
+				expected[cell] = state;
+			}
+			for(CellIndex cell = 0; cell < cellCount; cell++) {
+				if(space.GetState(cell) != expected[cell]) {
+					printf("FAIL stamps: cell %u state %d, expected %d in search %d\n", cell, space.GetState(cell),
+					       expected[cell], search);
+					failures++;
+				}
+			}
+			if(failures > 10) break;
+		}
+		return failures;
+	}
+
+	int CheckQueries(const char* name, Algorithm algorithm, SearchPolicy policy, bool terrain, std::mt19937& random) {
+		const uint size = 40;
+		const int queries = 150;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 25, random);
+		if(terrain) Reference::AddTerrain(map, 4, random);
+		JumpTable jumpTable;
+		jumpTable.Build(map.grid);
+
+		Search search;
+		search.SetGrid(&map.grid);
+		search.SetPolicy(policy);
+		search.SetCosts(terrain ? &map.costs : nullptr);
+		search.SetAlgorithm(algorithm, &jumpTable);
+		for(int i = 0; i < queries; i++) {
+			Position start = Reference::RandomFloor(map.grid, random);
+			Position end = Reference::RandomFloor(map.grid, random);
+			CellIndex startCell = map.grid.Index(start.x, start.y);
+			CellIndex endCell = map.grid.Index(end.x, end.y);
+
+			int cost = -1;
+			if(algorithm == Anytime) {
+				// Only the last path is optimal
+				search.Begin(startCell, endCell);
+				search.Step(StepBudget{});
+				if(search.Found()) cost = search.GetGCost(endCell);
+			}
+			else {
+				PathResult result = search.Solve(startCell, endCell);
+				if(result.found) cost = result.cost;
+			}
+			int expected = Reference::Cost(map.grid, startCell, endCell, policy, terrain ? &map.costs : nullptr);
+			if(cost != expected) {
+				printf("FAIL %s: %u,%u -> %u,%u cost %d, expected %d\n", name, start.x, start.y, end.x, end.y, cost, expected);
+				failures++;
+			}
+			if(search.GetState(startCell) == Unvisited) {
+				printf("FAIL %s: start %u,%u not reached\n", name, start.x, start.y);
+				failures++;
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	SearchPolicy noCorners{ EightWayNoCorners, OctileCost, Octile };
+	SearchPolicy fourWay{ FourWay, OctileCost, Manhattan };
+	int failures = CheckStamps(random);
+	failures += CheckQueries("astar", AStar, SearchPolicy(), false, random);
+	failures += CheckQueries("astar no corners", AStar, noCorners, false, random);
+	failures += CheckQueries("astar 4-way", AStar, fourWay, false, random);
+	failures += CheckQueries("astar terrain", AStar, SearchPolicy(), true, random);
+	failures += CheckQueries("jps", JumpPointSearch, SearchPolicy(), false, random);
+	failures += CheckQueries("jps+", JumpPointSearchPlus, SearchPolicy(), false, random);
+	failures += CheckQueries("bidirectional", Bidirectional, SearchPolicy(), false, random);
+	failures += CheckQueries("bidirectional terrain", Bidirectional, SearchPolicy(), true, random);
+	failures += CheckQueries("anytime", Anytime, SearchPolicy(), false, random);
+	failures += CheckQueries("anytime terrain", Anytime, SearchPolicy(), true, random);
+	return Reference::Finish(failures);
+}
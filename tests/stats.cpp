@@ -0,0 +1,95 @@
+#include "search.hpp"
+#include "reference.hpp"
+#include <cstdlib>
+
+// SearchStats counters against each other and against the search that made them. Pops never
+// outnumber pushes, every expansion is a pop, the open set never held more than was pushed,
+// A* closes exactly the cells it counts as expanded, and stepping counts the same work as Solve.
+// With stats compiled out everything has to stay zero.
+//
+//   PathfindingStatsTest [seed]
+
+using namespace Pathfinding;
+
+namespace {
+	bool SameCounters(const SearchStats& a, const SearchStats& b) {
+		return a.nodesExpanded == b.nodesExpanded && a.nodesGenerated == b.nodesGenerated && a.openSetPeak == b.openSetPeak
+		       && a.heapPushes == b.heapPushes && a.heapPops == b.heapPops && a.heapUpdates == b.heapUpdates
+		       && a.reopened == b.reopened;
+	}
+
+	int CheckCounters(const char* name, Algorithm algorithm, bool terrain, std::mt19937& random) {
+		const uint size = 40;
+		const int queries = 100;
+		int failures = 0;
+		MapData map = Reference::RandomMap(size, size, 25, random);
+		if(terrain) Reference::AddTerrain(map, 4, random);
+		JumpTable jumpTable;
+		jumpTable.Build(map.grid);
+		Components components;
+		components.Build(map.grid);
+
+		Search search;
+		search.SetGrid(&map.grid);
+		search.SetCosts(terrain ? &map.costs : nullptr);
+		search.SetComponents(&components);
+		search.SetAlgorithm(algorithm, &jumpTable);
+		auto fail = [&](const char* what, Position start, Position end) {
+			printf("FAIL %s: %u,%u -> %u,%u %s\n", name, start.x, start.y, end.x, end.y, what);
+			failures++;
+		};
+
+		for(int i = 0; i < queries && failures < 10; i++) {
+			Position start = Reference::RandomFloor(map.grid, random);
+			Position end = Reference::RandomFloor(map.grid, random);
+			CellIndex startCell = map.grid.Index(start.x, start.y);
+			CellIndex endCell = map.grid.Index(end.x, end.y);
+
+			PathResult result = search.Solve(startCell, endCell);
+			const SearchStats& stats = result.stats;
+			if(!SameCounters(stats, search.GetStats())) fail("result stats differ from the search's", start, end);
+
+			if(!PATHFINDING_STATS) {
+				if(!SameCounters(stats, SearchStats()) || stats.setupNs + stats.searchNs + stats.pathNs != 0) {
+					fail("counted with stats compiled out", start, end);
+				}
+				continue;
+			}
+			if(stats.heapPops > stats.heapPushes) fail("more pops than pushes", start, end);
+			if(stats.nodesExpanded > stats.heapPops) fail("expanded cells that weren't popped", start, end);
+			if(stats.openSetPeak > stats.heapPushes || stats.heapPushes - stats.heapPops > stats.openSetPeak) {
+				fail("open set peak doesn't match the pushes and pops", start, end);
+			}
+			if(!components.Connected(startCell, endCell) && !SameCounters(stats, SearchStats())) {
+				fail("counted work between components", start, end);
+			}
+			if(algorithm == AStar && !terrain) {
+				uint64_t closed = 0;
+				for(CellIndex cell = 0; cell < map.grid.CellCount(); cell++) {
+					if(search.GetState(cell) == Closed) closed++;
+				}
+				if(closed != stats.nodesExpanded || stats.reopened != 0) fail("closed cells don't match expansions", start, end);
+			}
+
+			// Stepping one cell at a time does the same work
+			SearchStats solved = search.GetStats();
+			search.Begin(startCell, endCell);
+			while(!search.Finished()) {
+				search.Step(StepBudget{ 1 });
+			}
+			if(algorithm != Anytime && !SameCounters(solved, search.GetStats())) fail("stepping counted other work", start, end);
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::mt19937 random(argc > 1 ? (uint)atoi(argv[1]) : 1);
+	int failures = CheckCounters("astar", AStar, false, random);
+	failures += CheckCounters("astar terrain", AStar, true, random);
+	failures += CheckCounters("jps", JumpPointSearch, false, random);
+	failures += CheckCounters("jps+", JumpPointSearchPlus, false, random);
+	failures += CheckCounters("bidirectional", Bidirectional, false, random);
+	failures += CheckCounters("anytime", Anytime, false, random);
+	return Reference::Finish(failures);
+}
@@ -0,0 +1,177 @@
+#include "batch.hpp"
+#include "mapio.hpp"
+#include "tiledsearch.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace {
+	// Tile memory split between the threads, and how many cells one search may reach before giving up
+	constexpr size_t TILE_MEMORY = (size_t)512 << 20;
+	constexpr size_t TILED_NODE_LIMIT = 1 << 24;
+
+	// Every thread opens the tiled map on its own and takes every threadCount-th query
+	bool SolveTiled(const char* path, const std::vector<Pathfinding::PathQuery>& batch, uint threadCount,
+	                Pathfinding::SearchPolicy policy, std::vector<Pathfinding::PathResult>& results) {
+		if(threadCount == 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		results.assign(batch.size(), Pathfinding::PathResult());
+		std::atomic<bool> failed{ false };
+
+		auto work = [&](uint index) {
+			Pathfinding::TiledMap map;
+			if(!map.Open(path, TILE_MEMORY / threadCount)) {
+				failed = true;
+				return;
+			}
+			Pathfinding::TiledSearch search;
+			search.SetMap(&map);
+			search.SetPolicy(policy);
+			search.SetNodeLimit(TILED_NODE_LIMIT);
+			for(size_t i = index; i < batch.size(); i += threadCount) {
+				const Pathfinding::PathQuery& q = batch[i];
+				if(!map.InBounds(q.start.x, q.start.y) || !map.InBounds(q.end.x, q.end.y)) continue;
+				results[i] = search.Solve(q.start, q.end);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for(uint i = 1; i < threadCount; i++) {
+			threads.emplace_back(work, i);
+		}
+		work(0);
+		for(std::thread& thread : threads) {
+			thread.join();
+		}
+		return !failed;
+	}
+}
+
+// Headless batch runner. Reads "startX startY endX endY" per line from the query file
+// and writes "startX startY endX endY cost x,y x,y ..." per query. Cost is -1 when there's no path.
+// Queries are solved on all hardware threads unless a thread count is given
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		printf("Usage: %s <map.bmp|map.pfmap|map.pftiles> <queries.txt> [output.txt] [threads] [astar|alt|bidir|jps|jps+|hpa|flow] [8|8strict|4] [palette.txt]\n", argv[0]);
+		return 1;
+	}
+
+	// Terrain colors and their costs, bitmaps only
+	Pathfinding::TerrainPalette palette;
+	if(argc > 7 && !Pathfinding::LoadPalette(argv[7], palette)) {
+		return 1;
+	}
+
+	// Tiled maps are read tile by tile while searching, not loaded up front
+	bool tiled = Pathfinding::IsTiledMap(argv[1]);
+	Pathfinding::MapData map;
+	if(!tiled && !Pathfinding::LoadMap(argv[1], map, &palette)) {
+		return 1;
+	}
+
+	std::ifstream queries(argv[2]);
+	if(!queries) {
+		printf("ERROR: Could not open %s\n", argv[2]);
+		return 1;
+	}
+
+	std::ofstream outputFile;
+	if(argc > 3 && std::string(argv[3]) != "-") {
+		outputFile.open(argv[3]);
+		if(!outputFile) {
+			printf("ERROR: Could not open %s\n", argv[3]);
+			return 1;
+		}
+	}
+	std::ostream& output = outputFile.is_open() ? outputFile : std::cout;
+	uint threads = argc > 4 ? (uint)atoi(argv[4]) : 0;
+
+	Pathfinding::Algorithm algorithm = Pathfinding::AStar;
+	bool hierarchical = false;
+	bool flowField = false;
+	bool landmarks = false;
+	if(argc > 5) {
+		std::string name = argv[5];
+		if(name == "jps") algorithm = Pathfinding::JumpPointSearch;
+		else if(name == "jps+") algorithm = Pathfinding::JumpPointSearchPlus;
+		else if(name == "bidir") algorithm = Pathfinding::Bidirectional;
+		else if(name == "hpa") hierarchical = true;
+		else if(name == "flow") flowField = true;
+		else if(name == "alt") landmarks = true;
+		else if(name != "astar") {
+			printf("ERROR: Unknown algorithm %s\n", argv[5]);
+			return 1;
+		}
+	}
+
+	// Diagonal moves past wall corners, diagonal moves only between open sides, or no diagonals
+	Pathfinding::SearchPolicy policy;
+	if(argc > 6) {
+		std::string moves = argv[6];
+		if(moves == "8strict") policy.connectivity = Pathfinding::EightWayNoCorners;
+		else if(moves == "4") {
+			policy.connectivity = Pathfinding::FourWay;
+			policy.metric = Pathfinding::Manhattan;
+		}
+		else if(moves != "8") {
+			printf("ERROR: Unknown moves %s\n", argv[6]);
+			return 1;
+		}
+	}
+
+	std::vector<Pathfinding::PathQuery> batch;
+	std::string line;
+	while(std::getline(queries, line)) {
+		std::istringstream fields(line);
+		Pathfinding::PathQuery query;
+		if(!(fields >> query.start.x >> query.start.y >> query.end.x >> query.end.y)) continue; // Skip blank and malformed lines
+		batch.push_back(query);
+	}
+
+	std::vector<Pathfinding::PathResult> results;
+	if(tiled) {
+		if(algorithm != Pathfinding::AStar || hierarchical || flowField || landmarks) {
+			printf("ERROR: Tiled maps only support astar\n");
+			return 1;
+		}
+		if(!SolveTiled(argv[1], batch, threads, policy, results)) {
+			return 1;
+		}
+	}
+	else {
+		Pathfinding::BatchSolver solver(map.grid, threads);
+		// Compact maps converted with --jump-table carry their JPS+ table
+		solver.SetJumpTable(std::move(map.jumpTable));
+		solver.SetAlgorithm(algorithm);
+		solver.SetPolicy(policy);
+		solver.SetCosts(&map.costs);
+		if(hierarchical) {
+			solver.SetHierarchical(16);
+		}
+		solver.SetFlowField(flowField);
+		// Repeated queries between the same places are answered from earlier paths
+		solver.SetCache(4096);
+		if(landmarks) {
+			solver.SetLandmarks(8);
+		}
+		results = solver.Solve(batch);
+	}
+
+	for(size_t i = 0; i < batch.size(); i++) {
+		const Pathfinding::PathQuery& query = batch[i];
+		const Pathfinding::PathResult& result = results[i];
+		output << query.start.x << ' ' << query.start.y << ' ' << query.end.x << ' ' << query.end.y << ' ';
+		output << (result.found ? result.cost : -1);
+		for(Pathfinding::Position pos : result.path) {
+			output << ' ' << pos.x << ',' << pos.y;
+		}
+		output << '\n';
+	}
+	return 0;
+}
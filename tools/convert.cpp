@@ -0,0 +1,55 @@
+#include "jumptable.hpp"
+#include "mapio.hpp"
+#include "tiledmap.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Converts a bitmap into a compact map file that loads with a single mmap.
+// --jump-table also stores a prebuilt JPS+ table, four int16 per cell.
+// --tiles writes a tiled map for TiledMap instead, in tiles of the given size (default 256)
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		printf("Usage: %s <map.bmp> <output.pfmap|output.pftiles> [--jump-table] [--tiles [size]]\n", argv[0]);
+		return 1;
+	}
+
+	bool withJumpTable = false;
+	uint tileSize = 0;
+	for(int i = 3; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg == "--jump-table") withJumpTable = true;
+		else if(arg == "--tiles") {
+			tileSize = 256;
+			if(i + 1 < argc && argv[i + 1][0] != '-') tileSize = (uint)atoi(argv[++i]);
+		}
+		else {
+			printf("ERROR: Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	Pathfinding::MapData map;
+	if(!Pathfinding::LoadMap(argv[1], map)) {
+		return 1;
+	}
+
+	if(tileSize != 0) {
+		if(!Pathfinding::SaveTiledMap(argv[2], map, tileSize)) {
+			return 1;
+		}
+		printf("%s: %ux%u in %ux%u tiles\n", argv[2], map.grid.Width(), map.grid.Height(), tileSize, tileSize);
+		return 0;
+	}
+
+	Pathfinding::JumpTable jumpTable;
+	if(withJumpTable) {
+		jumpTable.Build(map.grid);
+	}
+	if(!Pathfinding::SaveCompactMap(argv[2], map, withJumpTable ? &jumpTable : nullptr)) {
+		return 1;
+	}
+	printf("%s: %ux%u, %zu bytes of walkability\n", argv[2], map.grid.Width(), map.grid.Height(),
+	       map.grid.WordCount() * sizeof(uint64_t));
+	return 0;
+}